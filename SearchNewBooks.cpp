@@ -3,8 +3,10 @@
  * 
  * Main program for searching new books using different search strategies.
  * Reads book data from files, allows user to select search method (linear,
- * binary, or recursive binary), performs searches, times the search phase,
- * and outputs results.
+ * binary, recursive binary, batched merge, hash index, Eytzinger index,
+ * columnar SIMD scan, piecewise-linear learned index, interleaved batch
+ * binary search, or compressed catalog), performs searches (optionally on
+ * several threads), times the search phase, and outputs results.
  */
 
 #include <iostream>
@@ -13,164 +15,634 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <cstdlib>
+#include <optional>
+#include <utility>
+#include <atomic>
+#include <csignal>
+#include <unistd.h>
+#include <sys/resource.h>
 #include "book.h"
-#include "search.h"
+#include "book_sort.h"
+#include "loader.h"
+#include "pipeline.h"
+#include "results.h"
+#include "searcher.h"
+#include "server.h"
+#include "sharded_catalog.h"
+#include "snapshot.h"
 #include "Timer.h"
 
 using namespace std;
 
 /**
- * Parse a single line from a book data file into a Book object.
+ * Report how fast a data file was loaded.
  * 
- * Expected format: isbn,language,type
- * Example: 9780132350884,english,new
+ * @param path The file that was loaded
+ * @param stats Load statistics from loadBookFile()
+ */
+static void printLoadStats(const string &path, const LoadStats &stats) {
+    cout << "Loaded " << stats.records << " records from " << path
+         << " (" << stats.malformed << " malformed) in " << stats.microseconds << " microseconds, "
+         << stats.megabytesPerSecond() << " MB/s" << endl;
+}
+
+/**
+ * Command line options that are not positional arguments.
+ */
+struct Options {
+    unsigned threads = 1;  // --threads N: worker threads for the search phase
+    string snapshotOut;    // --write-snapshot PATH: save the prepared catalog and exit
+    bool stream = false;   // --stream: stream requests through the pipeline, one result line each
+    bool latency = false;  // --latency: time every lookup into a histogram
+    string statsJson;      // --stats-json PATH: write phase times (and latencies) as JSON
+    string method;         // --method X: search method letter, instead of prompting
+    bool serve = false;    // --serve: answer requests from stdin until end of input
+    string socketPath;     // --socket PATH: answer requests on a Unix domain socket until signalled
+    bool filter = false;   // --filter: put a Bloom filter in front of the search method
+    BloomSettings filterSettings;  // --filter-fpr P, --filter-max-bytes N (either implies --filter)
+    bool results = false;  // --results FORMAT: write per-request results instead of the count
+    ResultFormat resultFormat = ResultFormat::Text;
+    unsigned shards = 0;   // --shards N: search an ISBN-sharded, NUMA-placed catalog (0: unsharded)
+    size_t cacheEntries = 0;  // --cache N: result cache of N entries in front of the search (0: none)
+};
+
+/**
+ * Split argv into options and positional arguments.
+ * 
+ * Recognized options:
+ *   --threads N             Sort the catalog and search requests on N
+ *                           threads (default 1)
+ *   --write-snapshot PATH   Write the sorted catalog and its hash index to
+ *                           PATH, then exit without searching
+ *   --stream                Stream the requests file instead of loading it,
+ *                           writing one result line per request
+ *   --latency               Time every lookup and report p50/p90/p99/p999
+ *                           (adds a clock read per lookup to the search time)
+ *   --stats-json PATH       Write the phase times, and latencies if measured,
+ *                           to PATH as JSON
+ *   --method X              Use search method X (l, b, r, m, h, e, c, p, i or z)
+ *                           instead of prompting for it
+ *   --serve                 Server mode: answer request lines from stdin on
+ *                           stdout until end of input (needs --method)
+ *   --socket PATH           Server mode: answer clients of a Unix domain
+ *                           socket at PATH until SIGINT/SIGTERM
+ *   --filter                Reject misses with a Bloom filter over the
+ *                           catalog before searching (1% false positives)
+ *   --filter-fpr P          Filter target false-positive rate, in (0, 1)
+ *   --filter-max-bytes N    Filter memory cap in bytes (the false-positive
+ *                           rate rises if the target does not fit)
+ *   --results FORMAT        Write one result per request (index, hit or
+ *                           miss, catalog position) instead of the count;
+ *                           FORMAT is text or binary (see results.h)
+ *   --cache N               Answer repeated requests from a CLOCK result
+ *                           cache of about N entries (see result_cache.h)
+ *   --shards N              Split the catalog into N ISBN-range shards,
+ *                           each placed on a NUMA node and searched by a
+ *                           worker pinned there (replaces --threads for
+ *                           the search phase)
+ * 
+ * @param argc Argument count from main
+ * @param argv Argument vector from main
+ * @param opts Receives the parsed options
+ * @param positional Receives the remaining (positional) arguments in order
+ * @return false if an option is unknown or its value is invalid
+ */
+static bool parseOptions(int argc, char* argv[], Options &opts, vector<string> &positional) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--threads") {
+            if (i + 1 >= argc) return false;
+            char* end = nullptr;
+            long n = std::strtol(argv[++i], &end, 10);
+            if (*end != '\0' || n < 1) return false;
+            opts.threads = static_cast<unsigned>(n);
+        } else if (arg == "--write-snapshot") {
+            if (i + 1 >= argc) return false;
+            opts.snapshotOut = argv[++i];
+        } else if (arg == "--stream") {
+            opts.stream = true;
+        } else if (arg == "--latency") {
+            opts.latency = true;
+        } else if (arg == "--stats-json") {
+            if (i + 1 >= argc) return false;
+            opts.statsJson = argv[++i];
+        } else if (arg == "--method") {
+            SearchMethod method;
+            if (i + 1 >= argc || !parseSearchMethod(argv[i + 1], method)) return false;
+            opts.method = argv[++i];
+        } else if (arg == "--serve") {
+            opts.serve = true;
+        } else if (arg == "--socket") {
+            if (i + 1 >= argc) return false;
+            opts.socketPath = argv[++i];
+        } else if (arg == "--filter") {
+            opts.filter = true;
+        } else if (arg == "--filter-fpr") {
+            if (i + 1 >= argc) return false;
+            char* end = nullptr;
+            double p = std::strtod(argv[++i], &end);
+            if (*end != '\0' || !(p > 0 && p < 1)) return false;
+            opts.filter = true;
+            opts.filterSettings.falsePositiveRate = p;
+        } else if (arg == "--filter-max-bytes") {
+            if (i + 1 >= argc) return false;
+            char* end = nullptr;
+            long long n = std::strtoll(argv[++i], &end, 10);
+            if (*end != '\0' || n < 64) return false;
+            opts.filter = true;
+            opts.filterSettings.maxBytes = static_cast<size_t>(n);
+        } else if (arg == "--shards") {
+            if (i + 1 >= argc) return false;
+            char* end = nullptr;
+            long n = std::strtol(argv[++i], &end, 10);
+            if (*end != '\0' || n < 1) return false;
+            opts.shards = static_cast<unsigned>(n);
+        } else if (arg == "--cache") {
+            if (i + 1 >= argc) return false;
+            char* end = nullptr;
+            long long n = std::strtoll(argv[++i], &end, 10);
+            if (*end != '\0' || n < 1) return false;
+            opts.cacheEntries = static_cast<size_t>(n);
+        } else if (arg == "--results") {
+            if (i + 1 >= argc || !parseResultFormat(argv[i + 1], opts.resultFormat)) return false;
+            opts.results = true;
+            ++i;
+        } else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            return false;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    return true;
+}
+
+/**
+ * Read the process's resident memory.
+ *
+ * @param current Receives the resident set size now, in bytes (0 if unknown)
+ * @param peak Receives the largest resident set size so far, in bytes
+ */
+static void residentMemory(size_t &current, size_t &peak) {
+    current = 0;
+    size_t pages = 0, resident = 0;
+    ifstream statm("/proc/self/statm");
+    if (statm >> pages >> resident) current = resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    struct rusage usage;
+    peak = getrusage(RUSAGE_SELF, &usage) == 0 ? static_cast<size_t>(usage.ru_maxrss) * 1024 : 0;
+}
+
+/**
+ * Print the phase breakdown and latency summary, and write them as JSON if
+ * requested.
  * 
- * @param line The input string containing comma-separated book data
- * @param out Reference to Book object that will be populated with parsed data
- * @return true if parsing succeeded, false if line is malformed or empty
+ * @param opts Command line options (statsJson, threads)
+ * @param method The user's method choice
+ * @param searcher The searcher used, for its filter and cache counters and
+ *        compressed catalog size (nullptr for a sharded catalog)
+ * @param sharded The sharded catalog used, whose shards' filter and cache
+ *        counters are summed (nullptr if unsharded). Resident memory is
+ *        reported for every run
+ * @param phases Phase times of this run
+ * @param latency Per-lookup latencies, or nullptr if not measured
+ * @param requests Number of requests searched
+ * @param found Number of requests found
+ * @return false if the JSON file cannot be written
  */
-static bool parseBookLine(const string &line, Book &out) {
-    // Reject empty lines
-    if (line.empty()) return false;
-    
-    // Find first comma (separates ISBN from language)
-    size_t p1 = line.find(',');
-    if (p1 == string::npos) return false;
-    
-    // Find second comma (separates language from type)
-    size_t p2 = line.find(',', p1 + 1);
-    if (p2 == string::npos) return false;
-    
-    // Extract the three fields
-    string isbnStr = line.substr(0, p1);
-    string lang = line.substr(p1 + 1, p2 - p1 - 1);
-    string type = line.substr(p2 + 1);
-    
-    // Convert ISBN string to unsigned integer
-    try {
-        size_t isbn = std::stoull(isbnStr);
-        out = Book(lang, type, isbn);
-        return true;
-    } catch (...) {
-        // Invalid ISBN format (non-numeric or out of range)
+static bool reportInstrumentation(const Options &opts, const string &method, const Searcher *searcher,
+                                  const ShardedCatalog *sharded, const PhaseTimer &phases,
+                                  const LatencyHistogram *latency, size_t requests, size_t found) {
+    cout << "Phases:" << endl;
+    phases.Print(cout);
+    if (latency != nullptr) {
+        cout << "Lookup latency:" << endl;
+        latency->Print(cout);
+    }
+    // Filter and cache figures, summed over the shards of a sharded catalog
+    // (the largest hash count and expected fpr of any shard)
+    bool filter = false, cache = false;
+    size_t filterBytes = 0, cacheCapacity = 0;
+    unsigned filterHashes = 0;
+    double filterFpr = 0;
+    FilterStats filterStats;
+    CacheStats cacheStats;
+    auto addSearcher = [&](const Searcher &s) {
+        if (const BlockedBloomFilter *f = s.filter()) {
+            filter = true;
+            filterBytes += f->memoryBytes();
+            filterHashes = std::max(filterHashes, f->hashCount());
+            filterFpr = std::max(filterFpr, f->expectedFalsePositiveRate());
+            FilterStats fs = s.filterStats();
+            filterStats.rejected += fs.rejected;
+            filterStats.passed += fs.passed;
+            filterStats.falsePositives += fs.falsePositives;
+        }
+        if (const ResultCache *c = s.cache()) {
+            cache = true;
+            cacheCapacity += c->capacity();
+            CacheStats cs = s.cacheStats();
+            cacheStats.hits += cs.hits;
+            cacheStats.misses += cs.misses;
+            cacheStats.insertions += cs.insertions;
+            cacheStats.evictions += cs.evictions;
+        }
+    };
+    if (searcher != nullptr) addSearcher(*searcher);
+    for (size_t s = 0; sharded != nullptr && s < sharded->shards(); ++s) addSearcher(sharded->shardSearcher(s));
+    if (filter) {
+        cout << "Filter: " << filterBytes << " bytes, " << filterHashes << " hashes, expected fpr " << filterFpr
+             << "; " << filterStats.rejected << " rejected, " << filterStats.passed << " passed ("
+             << filterStats.falsePositives << " false positives)" << endl;
+    }
+    if (cache) {
+        cout << "Cache: " << cacheCapacity << " entries; " << cacheStats.hits << " hits, " << cacheStats.misses
+             << " misses, " << cacheStats.evictions << " evictions" << endl;
+    }
+    const CompressedCatalog *compressed = searcher != nullptr ? searcher->compressedCatalog() : nullptr;
+    if (compressed != nullptr && compressed->size() > 0) {
+        cout << "Compressed catalog structure: " << compressed->memoryBytes() << " bytes ("
+             << 8.0 * compressed->memoryBytes() / compressed->size() << " bits per book), " << compressed->blocks()
+             << " blocks, " << compressed->editions() << " editions" << endl;
+    }
+    size_t rss, peakRss;
+    residentMemory(rss, peakRss);
+    cout << "Memory: " << rss << " bytes resident, " << peakRss << " bytes peak" << endl;
+    if (opts.statsJson.empty()) return true;
+
+    ofstream json(opts.statsJson);
+    if (!json.is_open()) {
+        cerr << "Error: cannot open stats file " << opts.statsJson << endl;
         return false;
     }
+    json << "{\"method\": \"" << method << "\", \"threads\": " << opts.threads << ", \"shards\": " << opts.shards
+         << ", \"requests\": " << requests << ", \"found\": " << found << ", \"phases_us\": ";
+    phases.WriteJson(json);
+    json << ", \"total_us\": " << phases.TotalMicroseconds() << ", \"rss_bytes\": " << rss
+         << ", \"peak_rss_bytes\": " << peakRss;
+    if (latency != nullptr) {
+        json << ", \"latency_ns\": ";
+        latency->WriteJson(json);
+    }
+    if (filter) {
+        json << ", \"filter\": {\"bytes\": " << filterBytes << ", \"hashes\": " << filterHashes
+             << ", \"expected_fpr\": " << filterFpr << ", \"rejected\": "
+             << filterStats.rejected << ", \"passed\": " << filterStats.passed << ", \"false_positives\": "
+             << filterStats.falsePositives << "}";
+    }
+    if (cache) {
+        json << ", \"cache\": {\"capacity\": " << cacheCapacity << ", \"hits\": " << cacheStats.hits
+             << ", \"misses\": " << cacheStats.misses << ", \"insertions\": " << cacheStats.insertions
+             << ", \"evictions\": " << cacheStats.evictions << "}";
+    }
+    if (compressed != nullptr) {
+        json << ", \"compressed\": {\"bytes\": " << compressed->memoryBytes() << ", \"books\": " << compressed->size()
+             << ", \"blocks\": " << compressed->blocks() << ", \"editions\": " << compressed->editions() << "}";
+    }
+    json << "}" << endl;
+    return true;
+}
+
+/** Set by SIGINT/SIGTERM to stop the socket server. */
+static std::atomic<bool> stopRequested{false};
+
+static void requestStop(int) {
+    stopRequested = true;
 }
 
 /**
- * Main program entry point.
+ * Run server mode on a prepared catalog: stdin/stdout with --serve, or a
+ * Unix domain socket with --socket.
  * 
- * Usage: SearchNewBooks <newbooks.dat> <requests.dat> [output_file.dat]
+ * @param opts Command line options (serve, socketPath)
+ * @param searcher Searcher over the prepared catalog
+ * @param phases Phase times; the serving time is added as "serve"
+ * @param method The method letter, for the JSON report
+ * @return Process exit code
+ */
+static int runServer(const Options &opts, const Searcher &searcher, PhaseTimer &phases, const string &method) {
+    ServerStats stats;
+    Timer timer;
+    bool ok;
+    if (opts.serve) {
+        ok = serveConnection(searcher, STDIN_FILENO, STDOUT_FILENO, &stats);
+    } else {
+        // No SA_RESTART, so the accept loop's poll() wakes up on the signal
+        struct sigaction sa = {};
+        sa.sa_handler = requestStop;
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+        cout << "Listening on " << opts.socketPath << endl;
+        string error;
+        ok = serveUnixSocket(searcher, opts.socketPath, stopRequested, &stats, &error);
+        if (!ok) cerr << "Error: cannot serve on " << opts.socketPath << ": " << error << endl;
+    }
+    phases.Add("serve", timer.ElapsedMicroseconds());
+    cout << "Served " << stats.requests << " requests (" << stats.malformed << " malformed) on "
+         << stats.connections << " connection(s), " << stats.found << " found" << endl;
+    bool reported = reportInstrumentation(opts, method, &searcher, nullptr, phases, nullptr, stats.requests, stats.found);
+    return ok && reported ? 0 : 1;
+}
+
+/**
+ * Build a snapshot: load and sort newbooks.dat, build the hash index, and
+ * write both to a snapshot file for later runs to map directly.
  * 
- * Algorithm:
- * 1. Parse command line arguments and validate file access
- * 2. Load all new books from the first file into a vector
- * 3. Sort books using operator< (by ISBN, then type, then language)
- * 4. Prompt user to select a search method (linear/binary/recursive)
- * 5. Preprocess data if needed (sort again for binary searches)
- * 6. Start timer and search for each requested book
- * 7. Stop timer and report elapsed time
- * 8. Write count of found books to output file
+ * @param booksPath The new books data file
+ * @param snapshotPath The snapshot file to write
+ * @param threads Threads for sorting the catalog
+ * @return Process exit code
  */
-int main(int argc, char* argv[]) {
-    // ===== Step 1: Validate command line arguments =====
-    if (argc < 3) {
-        std::cerr << "Usage: program <newbooks.dat> <requests.dat> [result_file.dat]" << std::endl;
+static int buildSnapshot(const string &booksPath, const string &snapshotPath, unsigned threads) {
+    vector<Book> books;
+    LoadStats stats;
+    if (!loadBookFile(booksPath, books, &stats)) {
+        std::cerr << "Error: cannot open file " << booksPath << std::endl;
         return 1;
     }
+    printLoadStats(booksPath, stats);
 
-    // ===== Step 2: Open and validate input files =====
-    ifstream newFile(argv[1]);  // File containing available new books
-    ifstream reqFile(argv[2]);  // File containing books to search for
-    if (!newFile.is_open()) {
-        std::cerr << "Error: cannot open file " << argv[1] << std::endl;
+    Timer timer;
+    parallelSortBooks(books, threads);
+    BookHashIndex index(books);
+    if (!writeSnapshot(snapshotPath, books, true, &index)) {
+        std::cerr << "Error: cannot write snapshot " << snapshotPath << std::endl;
         return 1;
     }
-    if (!reqFile.is_open()) {
-        std::cerr << "Error: cannot open file " << argv[2] << std::endl;
+    cout << "Wrote snapshot " << snapshotPath << " (" << books.size() << " records) in "
+         << timer.ElapsedMicroseconds() << " microseconds" << endl;
+    return 0;
+}
+
+/**
+ * Main program entry point.
+ * 
+ * Usage: SearchNewBooks [--threads N | --shards N] [--filter[-fpr P]] [--stream | --results FORMAT] [--latency] [--stats-json PATH] <newbooks.dat|catalog.snap> <requests.dat> [output_file.dat]
+ *        SearchNewBooks --write-snapshot <catalog.snap> <newbooks.dat>
+ *        SearchNewBooks --method X (--serve | --socket PATH) <newbooks.dat|catalog.snap>
+ * 
+ * The first file may be a snapshot written by --write-snapshot, in which
+ * case it is mapped and used as-is: no parsing, no sorting, and the hash
+ * index is restored instead of rebuilt.
+ * 
+ * With --stream the requests file is never loaded: it is read, parsed,
+ * searched and written out chunk by chunk (see pipeline.h), and the output
+ * file gets every request line with its result instead of a count.
+ * 
+ * With --results the requests are searched as usual, but the output file
+ * gets one record per request (text or binary, see results.h) instead of
+ * the count. The search phase only stores a hit flag per request; the
+ * catalog positions of the hits are looked up while writing, in the
+ * output phase.
+ * 
+ * With --shards N the sorted catalog is split into N ISBN ranges, each
+ * copied and indexed by a thread pinned to one NUMA node (see
+ * sharded_catalog.h), and each shard's requests are searched on its node.
+ * --filter and --cache then give every shard its own filter and cache.
+ * 
+ * In server mode (--serve or --socket) there is no requests file: the
+ * catalog is prepared once and then requests are answered as they arrive,
+ * one result line per request (see server.h), until the input ends or the
+ * process is signalled.
+ * 
+ * With --filter (or --filter-fpr / --filter-max-bytes) a Bloom filter over
+ * the catalog is built with the index and consulted before every lookup,
+ * so most misses never reach the search method; its counters are reported
+ * with the phases. --cache N puts a result cache in front of that, so
+ * repeated requests skip the filter and the search; its hit, miss and
+ * eviction counts are reported the same way.
+ * 
+ * Every run ends with a breakdown of its phases (load books, load requests,
+ * sort, index build, search or stream, output); --latency adds a per-lookup
+ * latency histogram and --stats-json writes both as JSON.
+ * 
+ * Algorithm:
+ * 1. Parse command line arguments
+ * 2. Map and load all new books from the first file into a vector
+ * 3. Map and parse all requests into a buffer
+ * 4. Sort books using operator< (by ISBN, then type, then language)
+ * 5. Prompt user to select a search method (linear/binary/recursive/merge/hash/eytzinger/columnar/learned/interleaved/compressed)
+ * 6. Preprocess data if needed (sort again for binary searches, build the
+ *    hash, Eytzinger, columnar or learned index or the compressed catalog -
+ *    timed and reported separately)
+ * 7. Start timer and search for the requests, split across N threads
+ * 8. Stop timer and report elapsed time
+ * 9. Write count of found books (or the result set) to output file
+ * 10. Report the time of every phase (and lookup latencies with --latency)
+ */
+int main(int argc, char* argv[]) {
+    // ===== Step 1: Validate command line arguments =====
+    Options opts;
+    vector<string> args;
+    bool ok = parseOptions(argc, argv, opts, args);
+    if (ok && !opts.snapshotOut.empty() && args.size() == 1) {
+        return buildSnapshot(args[0], opts.snapshotOut, opts.threads);
+    }
+    bool serving = opts.serve || !opts.socketPath.empty();
+    bool resultsConflict = opts.results && (opts.stream || serving);
+    bool shardsConflict = opts.shards > 0 && (opts.stream || serving);
+    if (!ok || resultsConflict || shardsConflict || !opts.snapshotOut.empty() || args.size() < (serving ? 1u : 2u) || (opts.serve && opts.method.empty())) {
+        std::cerr << "Usage: program [--threads N] [--method X] [--filter] [--filter-fpr P] [--filter-max-bytes N] [--cache N] [--shards N] [--stream | --results text|binary] [--latency] [--stats-json PATH] <newbooks.dat|catalog.snap> <requests.dat> [result_file.dat]" << std::endl;
+        std::cerr << "       program --write-snapshot <catalog.snap> <newbooks.dat>" << std::endl;
+        std::cerr << "       program --method X (--serve | --socket PATH) [--threads N] <newbooks.dat|catalog.snap>" << std::endl;
         return 1;
     }
 
-    // ===== Step 3: Load all books from the new books file =====
+    // With --serve, stdout carries the responses; send everything else to stderr
+    if (opts.serve) cout.rdbuf(cerr.rdbuf());
+
+    // ===== Step 2-3: Map and load all books from the new books file =====
+    // A snapshot is mapped and copied out as-is (already sorted, hash index
+    // included); a data file is parsed in place from an mmap, skipping
+    // malformed lines
+    // Each step records its wall time as a named phase
+    PhaseTimer phases;
+    auto loadPhase = phases.Phase("load books");
     vector<Book> books;
-    string line;
-    while (std::getline(newFile, line)) {
-        Book b;
-        if (parseBookLine(line, b)) books.push_back(b);
+    bool booksSorted = false;
+    std::optional<BookHashIndex> savedHashIndex;
+    if (isSnapshotFile(args[0])) {
+        Timer snapshotTimer;
+        Snapshot snapshot;
+        string error;
+        if (!loadSnapshot(args[0], snapshot, &error)) {
+            std::cerr << "Error: cannot load snapshot " << args[0] << ": " << error << std::endl;
+            return 1;
+        }
+        books = std::move(snapshot.books);
+        booksSorted = snapshot.sorted;
+        savedHashIndex = std::move(snapshot.hashIndex);
+        cout << "Loaded snapshot " << args[0] << " (" << books.size() << " records) in "
+             << snapshotTimer.ElapsedMicroseconds() << " microseconds" << endl;
+    } else {
+        LoadStats bookStats;
+        if (!loadBookFile(args[0], books, &bookStats)) {
+            std::cerr << "Error: cannot open file " << args[0] << std::endl;
+            return 1;
+        }
+        printLoadStats(args[0], bookStats);
+    }
+    loadPhase.Stop();
+
+    // ===== Step 3b: Map and parse every request into a buffer =====
+    // Parsing (and interning) happens here on one thread, so the workers
+    // only ever see encoded requests and never touch the dictionaries.
+    // In streaming mode the pipeline parses the requests as it goes instead
+    vector<Book> requests;
+    if (!opts.stream && !serving) {
+        auto phase = phases.Phase("load requests");
+        LoadStats requestStats;
+        if (!loadBookFile(args[1], requests, &requestStats)) {
+            std::cerr << "Error: cannot open file " << args[1] << std::endl;
+            return 1;
+        }
+        printLoadStats(args[1], requestStats);
     }
 
     // ===== Step 4: Sort books for efficient searching =====
-    // Uses Book::operator< which orders by: ISBN -> type -> language
-    std::sort(books.begin(), books.end());
+    // Uses Book::operator< order: ISBN -> type -> language (integer ids),
+    // via a radix sort on the ISBN split across the --threads workers.
+    // Skipped when the snapshot says its records are already sorted
+    if (!booksSorted) {
+        auto phase = phases.Phase("sort");
+        parallelSortBooks(books, opts.threads);
+    }
 
     // ===== Step 5: Determine output filename =====
     // Use third argument if provided, otherwise default to "found.dat"
     string outFileName = "found.dat";
-    if (argc >= 4) outFileName = argv[3];
+    if (args.size() >= 3) outFileName = args[2];
 
     // ===== Step 6: Get search method from user =====
     // l = linear search O(n)
     // b = binary search O(log n)
     // r = recursive binary search O(log n)
-    string userInput;
-    while (true) {
-        cerr << "Choice of search method ([l]inear, [b]inary, [r]ecursiveBinary)? ";
-        cin >> userInput;
-        if (userInput == "l" || userInput == "b" || userInput == "r") break;
+    // m = batched merge search O(n + m) after sorting the requests
+    // h = hash index search O(1) expected per request
+    // e = Eytzinger-ordered ISBN index O(log n), cache-friendly
+    // c = columnar linear scan O(n) with SIMD kernels
+    // p = piecewise-linear learned ISBN index, O(log epsilon) windowed search
+    // i = interleaved binary search O(log n), 16 lookups in lockstep with prefetch
+    // z = compressed catalog, skip-index search then one SIMD-unpacked block
+    // Skipped when --method chose one already
+    string userInput = opts.method;
+    SearchMethod method;
+    while (!parseSearchMethod(userInput, method)) {
+        cerr << "Choice of search method ([l]inear, [b]inary, [r]ecursiveBinary, [m]erge, [h]ash, [e]ytzinger, [c]olumnar, [p]iecewise-linear, [i]nterleaved, [z] compressed)? ";
+        if (!(cin >> userInput)) return 1;
+        if (parseSearchMethod(userInput, method)) break;
         cerr << "Incorrect choice" << endl;
     }
 
-    // ===== Step 7: Preprocessing - ensure data is sorted for binary searches =====
-    size_t found_count = 0;
-    // Binary and recursive binary searches require sorted data
-    // Sort again to be absolutely certain (belt-and-suspenders approach)
-    if (userInput == "b" || userInput == "r") {
-        std::sort(books.begin(), books.end());
+    // ===== Step 7: Preprocessing - ensure data is sorted and build indexes =====
+    // Binary, recursive binary, merge, Eytzinger, learned, interleaved and compressed searches require sorted data
+    // Verify it to be absolutely certain (belt-and-suspenders approach) with
+    // a linear check rather than a second full sort
+    if (method == SearchMethod::Binary || method == SearchMethod::RecursiveBinary
+        || method == SearchMethod::Merge || method == SearchMethod::Eytzinger || method == SearchMethod::Learned
+        || method == SearchMethod::Interleaved || method == SearchMethod::Compressed) {
+        auto phase = phases.Phase("sort");
+        if (!std::is_sorted(books.begin(), books.end())) parallelSortBooks(books, opts.threads);
+    }
+
+    // Hash, Eytzinger, columnar, learned and compressed searches need their index built up front;
+    // this is preprocessing, so it gets its own timer and is reported
+    // separately from the probe time
+    // The optional Bloom filter and result cache are built here too. With --shards, each shard
+    // copies its records and builds its own index, filter and cache on its node instead
+    // The compressed catalog replaces the books vector, which is freed once
+    // the catalog is built (peak memory still includes the load and sort)
+    Timer buildTimer;
+    std::optional<Searcher> searcher;
+    std::optional<ShardedCatalog> sharded;
+    if (opts.shards > 0) {
+        sharded.emplace(books, opts.shards, method);
+        cout << "Sharded catalog: " << sharded->shards() << " shards over " << sharded->nodes().size()
+             << " NUMA node(s)" << endl;
+        if (opts.filter) sharded->enableFilter(opts.filterSettings);
+        if (opts.cacheEntries > 0) sharded->enableCache(CacheSettings{opts.cacheEntries});
+    } else {
+        if (method == SearchMethod::Compressed) {
+            CompressedCatalog catalog(books);
+            vector<Book>().swap(books);
+            searcher.emplace(std::move(catalog));
+        } else {
+            searcher.emplace(books, method, std::move(savedHashIndex));
+        }
+        if (opts.filter) searcher->enableFilter(opts.filterSettings);
+        if (opts.cacheEntries > 0) searcher->enableCache(CacheSettings{opts.cacheEntries});
+    }
+    double build_us = buildTimer.ElapsedMicroseconds();
+    phases.Add("index build", build_us);
+    if (methodBuildsIndex(method) || opts.filter || sharded) {
+        cout << "\n\nIndex build time: " << build_us << " microseconds" << endl;
+    }
+
+    // ===== Server mode: answer requests as they arrive =====
+    if (serving) return runServer(opts, *searcher, phases, userInput);
+
+    // ===== Streaming mode: read, search and write in one overlapped pass =====
+    // The timer covers the whole pass, since reading and writing overlap
+    // with the searches
+    if (opts.stream) {
+        StreamStats streamStats;
+        bool streamed = streamSearch(*searcher, args[1], outFileName, opts.threads, &streamStats);
+        if (!streamed) {
+            cerr << "Error: streaming " << args[1] << " to " << outFileName << " failed" << endl;
+            return 1;
+        }
+        cout << "\n\nStreamed " << streamStats.requests << " requests (" << streamStats.malformed << " malformed), "
+             << streamStats.found << " found" << endl;
+        cout << "CPU time: " << streamStats.microseconds << " microseconds" << endl;
+        phases.Add("stream", streamStats.microseconds);
+        return reportInstrumentation(opts, userInput, &*searcher, nullptr, phases, nullptr, streamStats.requests, streamStats.found) ? 0 : 1;
     }
 
     // ===== Step 8: START TIMING - measure only the search phase =====
+    // With --results the per-request flags are allocated before the timer
+    vector<uint8_t> hits(opts.results ? requests.size() : 0);
     Timer timer;
     timer.Reset();
 
-    // ===== Step 9: Process each search request =====
-    while (std::getline(reqFile, line)) {
-        Book req;
-        if (!parseBookLine(line, req)) continue;  // Skip malformed lines
-        
-        bool found = false;
-        
-        // Dispatch to the appropriate search algorithm
-        if (userInput == "l") {
-            // Linear search: check every book sequentially
-            found = linearSearch(books, req.getLanguage(), req.getType(), req.getISBN());
-        } else if (userInput == "b") {
-            // Iterative binary search: divide and conquer
-            found = binarySearch(books, req.getLanguage(), req.getType(), req.getISBN());
-        } else if (userInput == "r") {
-            // Recursive binary search: divide and conquer (recursive implementation)
-            if (!books.empty()) {
-                found = recursiveBinarySearch(books, req.getLanguage(), req.getType(), req.getISBN(), 0, books.size()-1);
-            } else {
-                found = false;
-            }
-        }
-        
-        // Increment counter if book was found in inventory
-        if (found) ++found_count;
-    }
+    // ===== Step 9: Search the requests =====
+    // The buffer is split into one chunk per thread; each thread counts its
+    // own hits and the counts are summed after the join. With --latency each
+    // thread also fills its own histogram, merged after the join; with
+    // --results each thread also flags its own slice of the hits vector.
+    // With --shards the requests are routed to their shards instead, and
+    // each shard's bucket is searched by a worker on the shard's node
+    LatencyHistogram latency;
+    size_t found_count = sharded ? sharded->countFound(requests, opts.results ? &hits : nullptr)
+                                 : searcher->countFoundParallel(requests, opts.threads, opts.latency ? &latency : nullptr,
+                                                                opts.results ? &hits : nullptr);
 
     // ===== Step 10: STOP TIMING and report performance =====
     double elapsed_us = timer.ElapsedMicroseconds();
+    phases.Add("search", elapsed_us);
     cout << "\n\nCPU time: " << elapsed_us << " microseconds" << endl;
 
     // ===== Step 11: Write results to output file =====
-    ofstream out(outFileName);
-    if (!out.is_open()) {
-        cerr << "Error: cannot open output file " << outFileName << endl;
-        return 1;
+    // The count of found books, or with --results one record per request
+    auto outputPhase = phases.Phase("output");
+    if (opts.results) {
+        bool written = searcher && searcher->compressedCatalog() != nullptr
+                           ? writeResultSet(outFileName, opts.resultFormat, *searcher->compressedCatalog(), requests, hits)
+                           : writeResultSet(outFileName, opts.resultFormat, books, requests, hits);
+        if (!written) {
+            cerr << "Error: cannot write results to " << outFileName << endl;
+            return 1;
+        }
+    } else {
+        ofstream out(outFileName);
+        if (!out.is_open()) {
+            cerr << "Error: cannot open output file " << outFileName << endl;
+            return 1;
+        }
+        out << found_count << std::endl;  // Write only the count of found books
+        out.close();
     }
-    out << found_count << std::endl;  // Write only the count of found books
-    out.close();
+    outputPhase.Stop();
 
-    return 0;
-}
\ No newline at end of file
+    // ===== Step 12: Report phases and latencies =====
+    bool timedLookups = opts.latency && !methodAnswersBatches(method) && !sharded;
+    return reportInstrumentation(opts, userInput, searcher ? &*searcher : nullptr, sharded ? &*sharded : nullptr, phases, timedLookups ? &latency : nullptr, requests.size(), found_count) ? 0 : 1;
+}
@@ -14,13 +14,30 @@
  *   timer.Reset();            // Restart timer
  *   // ... code to measure ...
  *   std::cout << timer;       // Print elapsed time using operator<<
+ *
+ * On top of Timer, this header provides a small instrumentation layer:
+ *   PhaseTimer phases;
+ *   {
+ *     auto phase = phases.Phase("sort");  // Timed until the end of the scope
+ *     // ... sort ...
+ *   }
+ *   LatencyHistogram latency;
+ *   latency.Record(ns);       // One sample per lookup
+ *   latency.Percentile(99);   // p99 in nanoseconds
+ *   phases.WriteJson(os);     // Both can be printed or emitted as JSON
  */
 
 #ifndef TIMER_H
 #define TIMER_H
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
 
 /**
  * Timer - High-precision timer for performance measurement.
@@ -75,4 +92,218 @@ class Timer {
   std::chrono::high_resolution_clock::time_point start_;  ///< Start time for timing measurement
 };
 
+/**
+ * PhaseTimer - Wall time of the named phases of a run, in order.
+ * 
+ * Phases are recorded either with a scope (Phase()) or explicitly (Add()).
+ * Recording a name that already exists adds to its time, so a phase that
+ * runs in several pieces is reported once.
+ */
+class PhaseTimer {
+ public:
+  /**
+   * Scope - Times one phase from construction until Stop() or destruction.
+   */
+  class Scope {
+   public:
+    Scope(PhaseTimer& owner, std::string name) : owner_(&owner), name_(std::move(name)) {}
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    ~Scope() { Stop(); }
+
+    /**
+     * End the phase now instead of at the end of the scope.
+     */
+    void Stop() {
+      if (owner_ == nullptr) return;
+      owner_->Add(name_, timer_.ElapsedMicroseconds());
+      owner_ = nullptr;
+    }
+
+   private:
+    PhaseTimer* owner_;
+    std::string name_;
+    Timer timer_;
+  };
+
+  /**
+   * Start timing a phase.
+   * 
+   * @param name Phase name, e.g. "sort"
+   * @return Scope that records the phase when it ends
+   */
+  Scope Phase(std::string name) { return Scope(*this, std::move(name)); }
+
+  /**
+   * Record time for a phase.
+   * 
+   * @param name Phase name
+   * @param microseconds Time to add to the phase
+   */
+  void Add(const std::string& name, double microseconds) {
+    for (auto& phase : phases_) {
+      if (phase.first == name) {
+        phase.second += microseconds;
+        return;
+      }
+    }
+    phases_.emplace_back(name, microseconds);
+  }
+
+  /**
+   * @return (name, microseconds) of every phase, in first-recorded order
+   */
+  const std::vector<std::pair<std::string, double>>& Phases() const { return phases_; }
+
+  /**
+   * @return Sum of all phase times in microseconds
+   */
+  double TotalMicroseconds() const {
+    double total = 0;
+    for (const auto& phase : phases_) total += phase.second;
+    return total;
+  }
+
+  /**
+   * Print one "name: time" line per phase, plus the total.
+   * 
+   * @param os Output stream
+   */
+  void Print(std::ostream& os) const {
+    for (const auto& phase : phases_) os << "  " << phase.first << ": " << phase.second << " microseconds\n";
+    os << "  total: " << TotalMicroseconds() << " microseconds\n";
+  }
+
+  /**
+   * Write the phases as a JSON object of name -> microseconds.
+   * 
+   * @param os Output stream
+   */
+  void WriteJson(std::ostream& os) const {
+    os << "{";
+    for (size_t i = 0; i < phases_.size(); ++i) {
+      os << (i ? ", " : "") << "\"" << phases_[i].first << "\": " << phases_[i].second;
+    }
+    os << "}";
+  }
+
+ private:
+  std::vector<std::pair<std::string, double>> phases_;
+};
+
+/**
+ * LatencyHistogram - HDR-style histogram of latencies in nanoseconds.
+ * 
+ * Values are bucketed log-linearly: every power of two is split into
+ * 2^kSubBucketBits equal sub-buckets, so any recorded value is known to
+ * within 1/32 (about 3%) of itself, from 1 ns up to the full 64-bit range,
+ * in a fixed 15 KB of counters. Recording is a count-leading-zeros and an
+ * increment, cheap enough to do for every lookup. Histograms from several
+ * threads are combined with Merge().
+ */
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+
+  LatencyHistogram() : counts_((64 - kSubBucketBits + 1) * kSubBuckets, 0) {}
+
+  /**
+   * Record one sample.
+   * 
+   * @param ns Latency in nanoseconds
+   */
+  void Record(uint64_t ns) {
+    ++counts_[BucketOf(ns)];
+    ++count_;
+    sum_ += ns;
+    min_ = std::min(min_, ns);
+    max_ = std::max(max_, ns);
+  }
+
+  /**
+   * Add every sample of another histogram to this one.
+   * 
+   * @param other Histogram to merge in
+   */
+  void Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < counts_.size(); ++i) counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+
+  uint64_t Count() const { return count_; }
+  uint64_t Min() const { return count_ ? min_ : 0; }
+  uint64_t Max() const { return max_; }
+  double Mean() const { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+
+  /**
+   * Value at a percentile.
+   * 
+   * @param percentile In [0, 100], e.g. 99.9
+   * @return The highest value equivalent to the sample at that rank (never
+   *         more than Max()), or 0 for an empty histogram
+   */
+  uint64_t Percentile(double percentile) const {
+    if (count_ == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * count_));
+    rank = std::max<uint64_t>(1, std::min(rank, count_));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < counts_.size(); ++b) {
+      seen += counts_[b];
+      if (seen >= rank) return std::min(HighestInBucket(b), max_);
+    }
+    return max_;
+  }
+
+  /**
+   * Print count, mean and the p50/p90/p99/p999 percentiles on one line.
+   * 
+   * @param os Output stream
+   */
+  void Print(std::ostream& os) const {
+    os << "  lookups: " << count_ << ", mean " << Mean() << " ns, p50 " << Percentile(50) << " ns, p90 "
+       << Percentile(90) << " ns, p99 " << Percentile(99) << " ns, p999 " << Percentile(99.9) << " ns, max "
+       << Max() << " ns\n";
+  }
+
+  /**
+   * Write the summary as a JSON object.
+   * 
+   * @param os Output stream
+   */
+  void WriteJson(std::ostream& os) const {
+    os << "{\"count\": " << count_ << ", \"min\": " << Min() << ", \"mean\": " << Mean()
+       << ", \"p50\": " << Percentile(50) << ", \"p90\": " << Percentile(90) << ", \"p99\": " << Percentile(99)
+       << ", \"p999\": " << Percentile(99.9) << ", \"max\": " << Max() << "}";
+  }
+
+ private:
+  /**
+   * Values below kSubBuckets get one bucket each; above that, the top
+   * kSubBucketBits + 1 bits select the sub-bucket within the value's power
+   * of two.
+   */
+  static size_t BucketOf(uint64_t v) {
+    if (v < kSubBuckets) return static_cast<size_t>(v);
+    int shift = 63 - __builtin_clzll(v) - kSubBucketBits;
+    return static_cast<size_t>((shift + 1) * kSubBuckets + ((v >> shift) - kSubBuckets));
+  }
+
+  static uint64_t HighestInBucket(size_t b) {
+    if (b < kSubBuckets) return b;
+    int shift = static_cast<int>(b / kSubBuckets) - 1;
+    uint64_t low = (kSubBuckets + b % kSubBuckets) << shift;
+    return low + ((uint64_t(1) << shift) - 1);
+  }
+
+  std::vector<uint64_t> counts_;
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t min_ = UINT64_MAX;
+  uint64_t max_ = 0;
+};
+
 #endif // TIMER_H
@@ -0,0 +1,33 @@
+/**
+ * arena.cpp
+ *
+ * Implementation of the string arena.
+ */
+
+#include "arena.h"
+#include <algorithm>
+#include <cstring>
+
+StringArena::StringArena(size_t blockBytes) : blockBytes_(std::max<size_t>(blockBytes, 1)) {}
+
+/**
+ * Start a new block that can hold at least bytes. The unused tail of the
+ * previous block is abandoned; with blocks much larger than the strings
+ * stored, that wastes little.
+ */
+void StringArena::grow(size_t bytes) {
+    size_t size = std::max(bytes, blockBytes_);
+    blocks_.emplace_back(new char[size]);
+    next_ = blocks_.back().get();
+    end_ = next_ + size;
+    allocated_ += size;
+}
+
+std::string_view StringArena::store(std::string_view s) {
+    if (static_cast<size_t>(end_ - next_) < s.size()) grow(s.size());
+    char* copy = next_;
+    if (!s.empty()) std::memcpy(copy, s.data(), s.size());
+    next_ += s.size();
+    used_ += s.size();
+    return std::string_view(copy, s.size());
+}
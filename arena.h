@@ -0,0 +1,70 @@
+/**
+ * arena.h
+ *
+ * Bump-pointer arena for string data that lives as long as its owner.
+ *
+ * Strings are copied back to back into large blocks, so storing one is a
+ * pointer bump rather than a malloc, neighbouring strings share cache
+ * lines, and the whole arena is released at once when it is destroyed
+ * (one free per block, not per string). Nothing is ever freed or moved
+ * individually, so every view returned by store() stays valid for the
+ * lifetime of the arena.
+ *
+ * The arena is not thread-safe; callers serialize access (see
+ * StringDictionary).
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/**
+ * StringArena - Append-only storage for string bytes.
+ */
+class StringArena {
+public:
+    /** Default block size; a larger string gets a block of its own size. */
+    static constexpr size_t kDefaultBlockBytes = 64 * 1024;
+
+    /**
+     * @param blockBytes Size of each block (the first one is allocated lazily)
+     */
+    explicit StringArena(size_t blockBytes = kDefaultBlockBytes);
+
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    /**
+     * Copy a string into the arena.
+     *
+     * @param s String to copy
+     * @return View of the copy, valid until the arena is destroyed
+     */
+    std::string_view store(std::string_view s);
+
+    /**
+     * @return Bytes of string data stored
+     */
+    size_t used() const { return used_; }
+
+    /**
+     * @return Bytes allocated for blocks (used plus unused tails)
+     */
+    size_t allocated() const { return allocated_; }
+
+private:
+    void grow(size_t bytes);
+
+    size_t blockBytes_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* next_ = nullptr;  // Free space in the current block: [next_, end_)
+    char* end_ = nullptr;
+    size_t used_ = 0;
+    size_t allocated_ = 0;
+};
+
+#endif // ARENA_H
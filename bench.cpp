@@ -0,0 +1,372 @@
+/**
+ * bench.cpp
+ *
+ * In-process benchmark harness for the search methods.
+ *
+ * For every catalog size, a synthetic catalog and request set are generated
+ * in memory, then each selected method is built once and run for a number
+ * of warmup and measured repetitions. Lookups are timed in small batches,
+ * giving a distribution of per-lookup latencies from which the median and
+ * p99 are reported, together with the overall throughput.
+ *
+ * Usage: bench [options]
+ *   --sizes N,N,...     Catalog sizes (default 1000,100000,1000000,10000000)
+ *   --lookups N         Requests per repetition (default 1000000)
+ *   --hit-ratio F       Fraction of requests present in the catalog (default 0.5)
+ *   --dist NAME         uniform | zipf | dups (default uniform)
+ *                         uniform: random 13-digit ISBNs, hits chosen uniformly
+ *                         zipf:    hits chosen by a Zipfian (s = 0.99) popularity
+ *                         dups:    8 editions (type/language) per ISBN
+ *   --methods LIST      Method letters as in SearchNewBooks (default lbrmhecpiz)
+ *   --warmup N          Unmeasured repetitions (default 1)
+ *   --reps N            Measured repetitions (default 5)
+ *   --csv PATH          Also write results as CSV
+ *   --json PATH         Also write results as JSON
+ *   --filter-fpr F      Put a Bloom filter with target false-positive rate
+ *                       F in front of every method (reported as "<m>+bloom")
+ *   --cache N           Put a result cache of N entries in front of every
+ *                       method (reported as "<m>+cache"); pair with
+ *                       --dist zipf to see repeated requests hit it
+ *   --sort-threads LIST Benchmark catalog sorting instead of lookups:
+ *                       std::sort against parallelSortBooks() at each of
+ *                       the given thread counts (e.g. 1,2,4,8)
+ *
+ * O(n)-per-lookup methods (l, c) are skipped for catalogs above 1M books and
+ * run on a prefix of the requests sized to scan about 2^28 books per
+ * repetition, so they do not dominate the run.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "book.h"
+#include "book_sort.h"
+#include "searcher.h"
+#include "Timer.h"
+
+using namespace std;
+
+/**
+ * Harness settings, filled from the command line.
+ */
+struct BenchConfig {
+    vector<size_t> sizes = {1000, 100000, 1000000, 10000000};
+    size_t lookups = 1000000;
+    double hitRatio = 0.5;
+    string dist = "uniform";
+    string methods = "lbrmhecpiz";
+    int warmup = 1;
+    int reps = 5;
+    string csvPath;
+    string jsonPath;
+    double filterFpr = 0;          // > 0: enable the Bloom filter
+    size_t cacheEntries = 0;       // > 0: enable the result cache
+    vector<unsigned> sortThreads;  // Non-empty: sort benchmark mode
+};
+
+/**
+ * One row of results: one method on one catalog.
+ */
+struct BenchResult {
+    size_t books;
+    string method;
+    size_t lookups;
+    double buildMs;
+    double medianNs;
+    double p99Ns;
+    double meanNs;
+    double throughputMlps;  // Million lookups per second
+    size_t found;
+};
+
+/** Requests timed together; small enough to resolve the tail, large enough to hide timer overhead. */
+static const size_t kBatch = 256;
+
+/** Books scanned per repetition by O(n)-per-lookup methods. */
+static const size_t kScanBudget = size_t(1) << 28;
+
+static const char* kLanguages[] = {"english", "french", "spanish", "german"};
+static const char* kTypes[] = {"new", "used"};
+
+static bool parseArgs(int argc, char* argv[], BenchConfig& cfg) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        string value = argv[++i];
+        if (arg == "--sizes") {
+            cfg.sizes.clear();
+            stringstream ss(value);
+            string item;
+            while (getline(ss, item, ',')) cfg.sizes.push_back(strtoull(item.c_str(), nullptr, 10));
+        } else if (arg == "--lookups") {
+            cfg.lookups = strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--hit-ratio") {
+            cfg.hitRatio = atof(value.c_str());
+        } else if (arg == "--dist") {
+            cfg.dist = value;
+            if (value != "uniform" && value != "zipf" && value != "dups") return false;
+        } else if (arg == "--methods") {
+            cfg.methods = value;
+        } else if (arg == "--warmup") {
+            cfg.warmup = atoi(value.c_str());
+        } else if (arg == "--reps") {
+            cfg.reps = atoi(value.c_str());
+        } else if (arg == "--csv") {
+            cfg.csvPath = value;
+        } else if (arg == "--json") {
+            cfg.jsonPath = value;
+        } else if (arg == "--filter-fpr") {
+            cfg.filterFpr = atof(value.c_str());
+            if (!(cfg.filterFpr > 0 && cfg.filterFpr < 1)) return false;
+        } else if (arg == "--cache") {
+            cfg.cacheEntries = strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--sort-threads") {
+            stringstream ss(value);
+            string item;
+            while (getline(ss, item, ',')) cfg.sortThreads.push_back(static_cast<unsigned>(atoi(item.c_str())));
+        } else {
+            return false;
+        }
+    }
+    return !cfg.sizes.empty() && cfg.lookups > 0 && cfg.reps > 0;
+}
+
+/**
+ * Generate a sorted catalog of n books.
+ *
+ * "dups" gives every ISBN 8 editions (2 types x 4 languages); the other
+ * distributions use one random type/language per ISBN.
+ */
+static vector<Book> makeCatalog(size_t n, const string& dist, mt19937_64& rng) {
+    uniform_int_distribution<size_t> isbnDist(9780000000000ULL, 9799999999999ULL);
+    vector<Book> books;
+    books.reserve(n);
+    while (books.size() < n) {
+        size_t isbn = isbnDist(rng);
+        if (dist == "dups") {
+            for (size_t e = 0; e < 8 && books.size() < n; ++e) books.push_back(Book(kLanguages[e % 4], kTypes[e / 4], isbn));
+        } else {
+            books.push_back(Book(kLanguages[rng() % 4], kTypes[rng() % 2], isbn));
+        }
+    }
+    sort(books.begin(), books.end());
+    return books;
+}
+
+/**
+ * Zipfian sampler over ranks [0, n) by inverse CDF on a precomputed table
+ * (capped at 1M distinct ranks to bound setup cost; ranks map onto catalog
+ * rows through a random permutation of the hot set).
+ */
+class ZipfSampler {
+public:
+    ZipfSampler(size_t n, double s) : cdf_(min<size_t>(n, 1000000)) {
+        double sum = 0;
+        for (size_t i = 0; i < cdf_.size(); ++i) {
+            sum += 1.0 / pow(static_cast<double>(i + 1), s);
+            cdf_[i] = sum;
+        }
+        for (auto& c : cdf_) c /= sum;
+    }
+
+    size_t operator()(mt19937_64& rng) {
+        double u = uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return min(cdf_.size() - 1, static_cast<size_t>(lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin()));
+    }
+
+private:
+    vector<double> cdf_;
+};
+
+/**
+ * Generate requests: hits are existing catalog rows, misses are random
+ * ISBNs (almost surely absent) or absent editions of present ISBNs.
+ */
+static vector<Book> makeRequests(const vector<Book>& books, const BenchConfig& cfg, mt19937_64& rng) {
+    uniform_int_distribution<size_t> isbnDist(9780000000000ULL, 9799999999999ULL);
+    uniform_real_distribution<double> coin(0.0, 1.0);
+    ZipfSampler zipf(books.size(), 0.99);
+    vector<size_t> hot(min<size_t>(books.size(), 1000000));
+    for (auto& h : hot) h = rng() % books.size();
+
+    vector<Book> requests;
+    requests.reserve(cfg.lookups);
+    for (size_t i = 0; i < cfg.lookups; ++i) {
+        if (coin(rng) < cfg.hitRatio) {
+            size_t row = cfg.dist == "zipf" ? hot[zipf(rng)] : rng() % books.size();
+            requests.push_back(books[row]);
+        } else if (cfg.dist == "dups") {
+            // Present ISBN, edition that does not exist ("digital")
+            requests.push_back(Book(kLanguages[rng() % 4], "digital", books[rng() % books.size()].getISBN()));
+        } else {
+            requests.push_back(Book(kLanguages[rng() % 4], kTypes[rng() % 2], isbnDist(rng)));
+        }
+    }
+    return requests;
+}
+
+static double percentile(vector<double>& v, double p) {
+    size_t k = min(v.size() - 1, static_cast<size_t>(p * (v.size() - 1) + 0.5));
+    nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+/**
+ * Run one method: build, warm up, then measured repetitions.
+ */
+static BenchResult runMethod(const vector<Book>& books, const vector<Book>& allRequests, char letter, const BenchConfig& cfg) {
+    SearchMethod method;
+    parseSearchMethod(string(1, letter), method);
+
+    size_t lookups = allRequests.size();
+    if (method == SearchMethod::Linear || method == SearchMethod::Columnar) {
+        lookups = min(lookups, max(kBatch, kScanBudget / books.size()));
+    }
+    vector<Book> requests(allRequests.begin(), allRequests.begin() + lookups);
+
+    Timer buildTimer;
+    Searcher searcher(books, method);
+    if (cfg.filterFpr > 0) {
+        BloomSettings settings;
+        settings.falsePositiveRate = cfg.filterFpr;
+        searcher.enableFilter(settings);
+    }
+    if (cfg.cacheEntries > 0) searcher.enableCache(CacheSettings{cfg.cacheEntries});
+    double buildMs = buildTimer.ElapsedMicroseconds() / 1000.0;
+
+    // Merge answers a whole batch at once, so it is timed per repetition
+    size_t batch = method == SearchMethod::Merge ? requests.size() : kBatch;
+
+    vector<double> samples;  // ns per lookup, one per timed batch
+    double totalUs = 0;
+    size_t found = 0;
+    for (int rep = 0; rep < cfg.warmup + cfg.reps; ++rep) {
+        bool measured = rep >= cfg.warmup;
+        found = 0;
+        for (size_t begin = 0; begin < requests.size(); begin += batch) {
+            size_t end = min(requests.size(), begin + batch);
+            Timer t;
+            found += searcher.countFound(requests, begin, end);
+            double us = t.ElapsedMicroseconds();
+            if (measured) {
+                samples.push_back(us * 1000.0 / (end - begin));
+                totalUs += us;
+            }
+        }
+    }
+
+    BenchResult r;
+    r.books = books.size();
+    r.method = string(1, letter) + (cfg.filterFpr > 0 ? "+bloom" : "") + (cfg.cacheEntries > 0 ? "+cache" : "");
+    r.lookups = requests.size();
+    r.buildMs = buildMs;
+    r.meanNs = totalUs * 1000.0 / (static_cast<double>(requests.size()) * cfg.reps);
+    r.medianNs = percentile(samples, 0.5);
+    r.p99Ns = percentile(samples, 0.99);
+    r.throughputMlps = 1000.0 / r.meanNs;
+    r.found = found;
+    return r;
+}
+
+static void writeCsv(ostream& os, const vector<BenchResult>& results, const BenchConfig& cfg) {
+    os << "books,dist,hit_ratio,method,lookups,build_ms,median_ns,p99_ns,mean_ns,throughput_mlps,found\n";
+    for (const auto& r : results) {
+        os << r.books << ',' << cfg.dist << ',' << cfg.hitRatio << ',' << r.method << ',' << r.lookups << ','
+           << r.buildMs << ',' << r.medianNs << ',' << r.p99Ns << ',' << r.meanNs << ',' << r.throughputMlps << ','
+           << r.found << '\n';
+    }
+}
+
+static void writeJson(ostream& os, const vector<BenchResult>& results, const BenchConfig& cfg) {
+    os << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        os << "  {\"books\": " << r.books << ", \"dist\": \"" << cfg.dist << "\", \"hit_ratio\": " << cfg.hitRatio
+           << ", \"method\": \"" << r.method << "\", \"lookups\": " << r.lookups << ", \"build_ms\": " << r.buildMs
+           << ", \"median_ns\": " << r.medianNs << ", \"p99_ns\": " << r.p99Ns << ", \"mean_ns\": " << r.meanNs
+           << ", \"throughput_mlps\": " << r.throughputMlps << ", \"found\": " << r.found << "}"
+           << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "]\n";
+}
+
+/**
+ * Sort benchmark: time std::sort and parallelSortBooks() on the same
+ * unsorted catalog, median of the repetitions, and print CSV.
+ */
+static int runSortBench(const BenchConfig& cfg) {
+    cout << "books,dist,sorter,threads,median_ms,speedup\n";
+    for (size_t n : cfg.sizes) {
+        mt19937_64 rng(42);
+        vector<Book> unsorted = makeCatalog(n, cfg.dist, rng);
+        shuffle(unsorted.begin(), unsorted.end(), rng);
+
+        auto timeSort = [&](unsigned threads) {
+            vector<double> ms;
+            for (int rep = 0; rep < cfg.warmup + cfg.reps; ++rep) {
+                vector<Book> books = unsorted;
+                Timer t;
+                if (threads == 0) sort(books.begin(), books.end());
+                else parallelSortBooks(books, threads);
+                if (rep >= cfg.warmup) ms.push_back(t.ElapsedMicroseconds() / 1000.0);
+            }
+            return percentile(ms, 0.5);
+        };
+
+        double baseline = timeSort(0);
+        cout << n << ',' << cfg.dist << ",std::sort,1," << baseline << ",1\n";
+        for (unsigned threads : cfg.sortThreads) {
+            double ms = timeSort(threads == 0 ? 1 : threads);
+            cout << n << ',' << cfg.dist << ",radix," << threads << ',' << ms << ',' << baseline / ms << '\n';
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+    if (!parseArgs(argc, argv, cfg)) {
+        cerr << "Usage: bench [--sizes N,N,...] [--lookups N] [--hit-ratio F] [--dist uniform|zipf|dups]"
+             << " [--methods lbrmhecpiz] [--warmup N] [--reps N] [--csv PATH] [--json PATH] [--filter-fpr F] [--cache N]"
+             << " [--sort-threads N,N,...]" << endl;
+        return 1;
+    }
+    if (!cfg.sortThreads.empty()) return runSortBench(cfg);
+
+    vector<BenchResult> results;
+    for (size_t n : cfg.sizes) {
+        mt19937_64 rng(42);
+        vector<Book> books = makeCatalog(n, cfg.dist, rng);
+        vector<Book> requests = makeRequests(books, cfg, rng);
+
+        for (char letter : cfg.methods) {
+            SearchMethod method;
+            if (!parseSearchMethod(string(1, letter), method)) {
+                cerr << "Unknown method '" << letter << "'" << endl;
+                return 1;
+            }
+            if ((method == SearchMethod::Linear || method == SearchMethod::Columnar) && n > 1000000) continue;
+            results.push_back(runMethod(books, requests, letter, cfg));
+            const auto& r = results.back();
+            cerr << n << " books, [" << r.method << "]: median " << r.medianNs << " ns, p99 " << r.p99Ns
+                 << " ns, " << r.throughputMlps << " M lookups/s" << endl;
+        }
+    }
+
+    writeCsv(cout, results, cfg);
+    if (!cfg.csvPath.empty()) {
+        ofstream f(cfg.csvPath);
+        writeCsv(f, results, cfg);
+    }
+    if (!cfg.jsonPath.empty()) {
+        ofstream f(cfg.jsonPath);
+        writeJson(f, results, cfg);
+    }
+    return 0;
+}
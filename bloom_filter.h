@@ -0,0 +1,106 @@
+/**
+ * bloom_filter.h
+ *
+ * Blocked Bloom filter over (ISBN, type, language), used to reject misses
+ * before they reach a search method.
+ *
+ * A classic Bloom filter spreads a key's k bits over the whole bit array,
+ * so a lookup costs up to k cache misses. Here the array is cut into
+ * 64-byte blocks: one hash picks the block, and all k bits of the key are
+ * set inside that block. A lookup therefore reads exactly one cache line,
+ * whether it hits or not, at the price of a higher false-positive rate for
+ * the same memory: keys do not spread evenly over blocks, and crowded
+ * blocks let more misses through. The filter is sized with that accounted
+ * for, so it still meets its target rate.
+ *
+ * The filter never gives a false negative: if mayContain() returns false,
+ * no book equal to the key was added.
+ */
+
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "book.h"
+
+/**
+ * BloomSettings - How to size a BlockedBloomFilter.
+ */
+struct BloomSettings {
+    double falsePositiveRate = 0.01;  // Target fraction of misses let through, in (0, 1)
+    size_t maxBytes = 0;              // Memory cap; 0 means no cap. A cap smaller than the
+                                      // target needs raises the false-positive rate instead
+};
+
+/**
+ * BlockedBloomFilter - Cache-line-blocked Bloom filter of books.
+ */
+class BlockedBloomFilter {
+public:
+    /**
+     * Build the filter over books.
+     *
+     * Time complexity: O(n)
+     * Space complexity: about 1.44 * log2(1 / fpr) bits per book, plus
+     *                   15-50% for blocking, in whole 64-byte blocks
+     *
+     * @param books Books to add (any order)
+     * @param settings Target false-positive rate and memory cap
+     */
+    BlockedBloomFilter(const std::vector<Book>& books, const BloomSettings& settings = BloomSettings());
+
+    /**
+     * Size an empty filter for count books, to be filled with add() (e.g.
+     * from a catalog that is not held as a vector).
+     *
+     * @param count Number of books that will be added
+     * @param settings Target false-positive rate and memory cap
+     */
+    BlockedBloomFilter(size_t count, const BloomSettings& settings = BloomSettings());
+
+    /**
+     * Add one book.
+     *
+     * @param book Encoded book
+     */
+    void add(const Book& book);
+
+    /**
+     * Membership test.
+     *
+     * @param key Encoded book to look for
+     * @return false if key was definitely not added; true if it may have been
+     */
+    bool mayContain(const Book& key) const;
+
+    /**
+     * @return Bytes used by the bit array
+     */
+    size_t memoryBytes() const { return blocks_.size() * sizeof(Block); }
+
+    /**
+     * @return Bits set per key
+     */
+    unsigned hashCount() const { return k_; }
+
+    /**
+     * Expected false-positive rate for the number of books added, taking
+     * the uneven load of the blocks into account.
+     *
+     * @return Expected fraction of absent keys for which mayContain() is true
+     */
+    double expectedFalsePositiveRate() const { return expectedFpr_; }
+
+private:
+    struct alignas(64) Block {
+        uint64_t words[8];
+    };
+
+    std::vector<Block> blocks_;
+    unsigned k_;
+    double expectedFpr_;
+};
+
+#endif // BLOOM_FILTER_H
@@ -7,6 +7,8 @@
  */
 
 #include "book.h"
+#include "dictionary.h"
+#include <stdexcept>
 #include <string>
 
 // ===== Constructors =====
@@ -14,97 +16,77 @@
 /**
  * Default constructor - initializes a book with default values.
  * Creates an empty book with ISBN 0.
+ * The ids of the empty strings are interned once and cached, so default
+ * construction never touches the dictionaries afterwards.
  */
-Book::Book() : language(""), type(""), isbn(0) {}
+Book::Book() : isbn(0), languageId(0), typeId(0) {
+    static const uint32_t emptyLanguage = languageDictionary().intern("");
+    static const uint16_t emptyType = static_cast<uint16_t>(typeDictionary().intern(""));
+    languageId = emptyLanguage;
+    typeId = emptyType;
+}
 
 /**
  * Parameterized constructor - initializes a book with given values.
- * Uses member initializer list for efficiency.
+ * Language and type are interned so the record only stores their ids.
  * 
  * @param lang The language of the book
  * @param t The type/condition (new, used, digital, etc.)
  * @param i The ISBN identifier
  */
-Book::Book(const std::string& lang, const std::string& t, size_t i) : language(lang), type(t), isbn(i) {}
+Book::Book(std::string_view lang, std::string_view t, size_t i)
+    : isbn(i), languageId(languageDictionary().intern(lang)), typeId(0) {
+    uint32_t tId = typeDictionary().intern(t);
+    if (tId >= kTypeIdLimit) throw std::length_error("too many distinct book types");
+    typeId = static_cast<uint16_t>(tId);
+}
+
+/**
+ * Encoded constructor - initializes a book from already-interned ids.
+ * 
+ * @param i The ISBN identifier
+ * @param langId Language id from languageDictionary()
+ * @param tId Type id from typeDictionary()
+ */
+Book::Book(size_t i, uint32_t langId, uint16_t tId) : isbn(i), languageId(langId), typeId(tId) {}
 
 // ===== Getter Methods =====
 
 /**
  * Get the language attribute.
- * @return Copy of the language string
+ * @return View of the interned language string
  */
-std::string Book::getLanguage() const {
-    return language;
+std::string_view Book::getLanguage() const {
+    return languageDictionary().name(languageId);
 }
 
 /**
  * Get the type/condition attribute.
- * @return Copy of the type string
- */
-std::string Book::getType() const {
-    return type;
-}
-
-/**
- * Get the ISBN identifier.
- * @return The ISBN number
+ * @return View of the interned type string
  */
-size_t Book::getISBN() const {
-    return isbn;
+std::string_view Book::getType() const {
+    return typeDictionary().name(typeId);
 }
 
-// ===== Operator Overloads =====
-
 /**
- * Less-than comparison operator for sorting.
+ * Encode a search target using find() on both dictionaries.
  * 
- * Implements a three-tier sorting hierarchy:
- * 1. Primary sort by ISBN (ascending)
- * 2. Secondary sort by type using custom ranking:
- *    - "new" books come first (rank 0)
- *    - "used" books come second (rank 1)
- *    - "digital" books come third (rank 2)
- *    - unknown types come last (rank 3)
- * 3. Tertiary sort by language (alphabetical)
- * 
- * @param other The book to compare against
- * @return true if this book should appear before 'other' in sorted order
+ * @param lang Target language
+ * @param type Target type
+ * @param isbn Target ISBN
+ * @param out Receives the encoded book on success
+ * @return false if either string has never been interned, or the type's
+ *         id is out of range
  */
-bool Book::operator<(const Book& other) const {
-    // Primary comparison: ISBN
-    if (isbn != other.isbn) return isbn < other.isbn;
-    
-    // Secondary comparison: Type (using custom ranking)
-    // Lambda function assigns numeric ranks to type strings
-    auto rank = [](const std::string &t){
-        if (t == "new") return 0;
-        if (t == "used") return 1;
-        if (t == "digital") return 2;
-        return 3; // unknown types go last
-    };
-    
-    int r1 = rank(type);
-    int r2 = rank(other.type);
-    if (r1 != r2) return r1 < r2;
-    
-    // Tertiary comparison: Language (alphabetical)
-    return language < other.language;
+bool encodeBook(std::string_view lang, std::string_view type, size_t isbn, Book& out) {
+    uint32_t langId = languageDictionary().find(lang);
+    uint32_t typeId = typeDictionary().find(type);
+    if (langId == StringDictionary::npos || typeId >= kTypeIdLimit) return false;  // npos is past the limit too
+    out = Book(isbn, langId, static_cast<uint16_t>(typeId));
+    return true;
 }
 
-/**
- * Equality comparison operator for exact matching.
- * 
- * Two books are considered equal if and only if ALL three attributes match:
- * - Same ISBN
- * - Same type
- * - Same language
- * 
- * @param other The book to compare against
- * @return true if all attributes are identical
- */
-bool Book::operator==(const Book& other) const {
-    return isbn == other.isbn && type == other.type && language == other.language;
-}
+// ===== Operator Overloads =====
 
 /**
  * Stream insertion operator for output formatting.
@@ -119,6 +101,6 @@ bool Book::operator==(const Book& other) const {
  * @return Reference to the output stream (allows chaining)
  */
 std::ostream& operator<<(std::ostream& os, const Book& book) {
-    os << "ISBN:" << book.isbn << ", Language:" << book.language << ", Type:" << book.type;
+    os << "ISBN:" << book.isbn << ", Language:" << book.getLanguage() << ", Type:" << book.getType();
     return os;
 }
@@ -4,6 +4,10 @@
  * Book class definition for representing individual books in inventory.
  * Each book has three attributes: ISBN (unique identifier), language, and type.
  * 
+ * Language and type are interned (see dictionary.h) and stored as small
+ * integer ids, so a Book is a packed 16-byte record and all comparisons are
+ * integer compares.
+ * 
  * The class provides:
  * - Constructors for initialization
  * - Getter methods for accessing private members
@@ -15,22 +19,44 @@
 #ifndef BOOK_H_LOWER
 #define BOOK_H_LOWER
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <ostream>
 
+/**
+ * BookType - Well-known type ids.
+ * 
+ * These are the ids the type dictionary assigns to "new", "used" and
+ * "digital". Any other type string is interned with an id >= Other.
+ */
+enum class BookType : uint16_t {
+    New = 0,
+    Used = 1,
+    Digital = 2,
+    Other = 3
+};
+
+/**
+ * Number of usable type ids. Type ids are stored in 16 bits and UINT16_MAX
+ * marks an empty BookHashIndex slot, so a type string interned past this
+ * limit is rejected instead of wrapping onto an existing type.
+ */
+constexpr uint32_t kTypeIdLimit = UINT16_MAX;
+
 /**
  * Book - Represents a single book with ISBN, language, and type attributes.
  * 
  * Books are compared and sorted by:
  * 1. ISBN (primary key)
- * 2. Type (secondary: new < used < digital)
- * 3. Language (tertiary: alphabetical)
+ * 2. Type (secondary: new < used < digital < other types)
+ * 3. Language (tertiary: by interned id, i.e. first-seen order)
  */
 class Book {
 private:
-    std::string language;  // Book language (e.g., "english", "french", "spanish")
-    std::string type;      // Book condition/format (e.g., "new", "used", "digital")
     size_t isbn;           // International Standard Book Number (unique identifier)
+    uint32_t languageId;   // Interned language (e.g., "english", "french", "spanish")
+    uint16_t typeId;       // Interned type, see BookType (e.g., "new", "used", "digital")
 
 public:
     /**
@@ -44,23 +70,44 @@ public:
      * @param lang The language of the book
      * @param t The type/condition of the book (new/used/digital)
      * @param i The ISBN number
+     * @throws std::length_error if t would be interned with an id of
+     *         kTypeIdLimit or more
+     */
+    Book(std::string_view lang, std::string_view t, size_t i);
+
+    /**
+     * Encoded constructor - creates a book from already-interned ids.
+     * 
+     * @param i The ISBN number
+     * @param langId Id from languageDictionary()
+     * @param tId Id from typeDictionary()
      */
-    Book(const std::string& lang, const std::string& t, size_t i);
+    Book(size_t i, uint32_t langId, uint16_t tId);
 
     /**
      * Getter methods - provide read-only access to private member variables.
+     * 
+     * Language and type are views of the interned strings, which live as long
+     * as the dictionaries (the whole program), so reading them never copies
+     * or allocates. Copy into a std::string only to modify the text.
      */
-    std::string getLanguage() const;
-    std::string getType() const;
+    std::string_view getLanguage() const;
+    std::string_view getType() const;
     size_t getISBN() const;
 
+    /**
+     * Encoded getters - the interned ids behind getLanguage()/getType().
+     */
+    uint32_t getLanguageId() const;
+    uint16_t getTypeId() const;
+
     /**
      * Less-than operator for sorting books.
      * 
      * Comparison order:
      * 1. Compare by ISBN (ascending)
-     * 2. If ISBNs are equal, compare by type (new < used < digital)
-     * 3. If types are also equal, compare by language (alphabetical)
+     * 2. If ISBNs are equal, compare by type (new < used < digital < other)
+     * 3. If types are also equal, compare by language id
      * 
      * @param other The book to compare with
      * @return true if this book should come before 'other' in sorted order
@@ -91,4 +138,80 @@ public:
     friend std::ostream& operator<<(std::ostream& os, const Book& book);
 };
 
+// ===== Inline Members =====
+// The accessors and comparisons are defined here rather than in book.cpp so
+// every search loop (and the templates in search_kernels.h) can inline them
+// down to plain integer compares.
+
+/**
+ * Get the ISBN identifier.
+ * @return The ISBN number
+ */
+inline size_t Book::getISBN() const {
+    return isbn;
+}
+
+/**
+ * Get the interned language id.
+ * @return Id into languageDictionary()
+ */
+inline uint32_t Book::getLanguageId() const {
+    return languageId;
+}
+
+/**
+ * Get the interned type id.
+ * @return Id into typeDictionary() (see BookType)
+ */
+inline uint16_t Book::getTypeId() const {
+    return typeId;
+}
+
+/**
+ * Less-than comparison operator for sorting.
+ * 
+ * Implements a three-tier sorting hierarchy:
+ * 1. Primary sort by ISBN (ascending)
+ * 2. Secondary sort by type id. The type dictionary reserves the ids
+ *    new = 0, used = 1, digital = 2, so the id is also the rank and
+ *    unknown types (id >= 3) come last.
+ * 3. Tertiary sort by language id
+ * 
+ * Type and language are folded into one 64-bit secondary key so the whole
+ * comparison is two integer compares with no string access.
+ */
+inline bool Book::operator<(const Book& other) const {
+    uint64_t k1 = (static_cast<uint64_t>(typeId) << 32) | languageId;
+    uint64_t k2 = (static_cast<uint64_t>(other.typeId) << 32) | other.languageId;
+    return (isbn < other.isbn) | ((isbn == other.isbn) & (k1 < k2));
+}
+
+/**
+ * Equality comparison operator for exact matching.
+ * 
+ * Two books are considered equal if and only if ALL three attributes match.
+ */
+inline bool Book::operator==(const Book& other) const {
+    return isbn == other.isbn && typeId == other.typeId && languageId == other.languageId;
+}
+
+/**
+ * Encode a search target without interning anything.
+ * 
+ * Looks up the language and type in the dictionaries with find(), so a
+ * request for a string no book has ever used does not grow them. Takes
+ * views, so callers holding a std::string, a literal or a slice of an input
+ * buffer encode without allocating.
+ * 
+ * @param lang Target language
+ * @param type Target type
+ * @param isbn Target ISBN
+ * @param out Receives the encoded book on success
+ * @return false if the language or type is unknown or the type id is not
+ *         below kTypeIdLimit (so no book can match)
+ */
+bool encodeBook(std::string_view lang, std::string_view type, size_t isbn, Book& out);
+
+static_assert(sizeof(Book) == 16, "Book is expected to be a packed 16-byte record");
+
 #endif // BOOK_H_LOWER
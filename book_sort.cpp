@@ -0,0 +1,172 @@
+/**
+ * book_sort.cpp
+ *
+ * Implementation of the parallel radix catalog sort.
+ */
+
+#include "book_sort.h"
+#include "parallel.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+/** Below this size std::sort is faster than setting up the radix passes. */
+static const size_t kRadixThreshold = 4096;
+
+static const int kRadixBits = 8;
+static const size_t kRadixBuckets = size_t(1) << kRadixBits;
+static const int kIsbnBytes = 8;
+
+/** Runs of equal ISBNs longer than this are tie-broken with std::sort. */
+static const size_t kInsertionRun = 16;
+
+using Histogram = std::array<size_t, kRadixBuckets>;
+
+static inline size_t digitOf(const Book& b, int byte) {
+    return (b.getISBN() >> (byte * kRadixBits)) & (kRadixBuckets - 1);
+}
+
+/**
+ * Find the ISBN bytes worth sorting on.
+ *
+ * One parallel pass builds all eight byte histograms at once; a byte whose
+ * histogram has a single non-empty bucket is the same in every book and
+ * cannot change the order.
+ */
+static std::vector<int> activeBytes(const std::vector<Book>& books, unsigned threads) {
+    std::vector<std::array<Histogram, kIsbnBytes>> counts(threads);
+    parallelFor(books.size(), threads, [&](unsigned t, size_t begin, size_t end) {
+        auto& c = counts[t];
+        for (auto& h : c) h.fill(0);
+        for (size_t i = begin; i < end; ++i) {
+            for (int byte = 0; byte < kIsbnBytes; ++byte) ++c[byte][digitOf(books[i], byte)];
+        }
+    });
+
+    std::vector<int> bytes;
+    for (int byte = 0; byte < kIsbnBytes; ++byte) {
+        size_t nonEmpty = 0;
+        for (size_t d = 0; d < kRadixBuckets; ++d) {
+            size_t total = 0;
+            for (unsigned t = 0; t < threads; ++t) total += counts[t][byte][d];
+            nonEmpty += total != 0;
+        }
+        if (nonEmpty > 1) bytes.push_back(byte);
+    }
+    return bytes;
+}
+
+/**
+ * One stable LSD pass on one ISBN byte, from src into dst.
+ *
+ * parallelFor cuts [0, n) the same way on every call, so thread t counts
+ * and then scatters exactly the same chunk. Thread t's books with digit d
+ * go after those of every earlier thread with digit d, which keeps the pass
+ * stable.
+ */
+static void radixPass(const std::vector<Book>& src, std::vector<Book>& dst, int byte, unsigned threads) {
+    std::vector<Histogram> offsets(threads);
+    parallelFor(src.size(), threads, [&](unsigned t, size_t begin, size_t end) {
+        Histogram& h = offsets[t];
+        h.fill(0);
+        for (size_t i = begin; i < end; ++i) ++h[digitOf(src[i], byte)];
+    });
+
+    // Exclusive prefix sum in (digit, thread) order
+    size_t next = 0;
+    for (size_t d = 0; d < kRadixBuckets; ++d) {
+        for (unsigned t = 0; t < threads; ++t) {
+            size_t count = offsets[t][d];
+            offsets[t][d] = next;
+            next += count;
+        }
+    }
+
+    parallelFor(src.size(), threads, [&](unsigned t, size_t begin, size_t end) {
+        Histogram& h = offsets[t];
+        for (size_t i = begin; i < end; ++i) dst[h[digitOf(src[i], byte)]++] = src[i];
+    });
+}
+
+/**
+ * Order every run of equal ISBNs in books[begin, end) by (type, language).
+ * begin and end must be run boundaries.
+ *
+ * Runs are usually a few editions long and get an insertion sort. Longer
+ * runs (one ISBN with thousands of records) go to std::sort, so a heavily
+ * duplicated ISBN costs O(k log k) rather than O(k^2).
+ */
+static void sortRuns(std::vector<Book>& books, size_t begin, size_t end) {
+    size_t i = begin;
+    while (i < end) {
+        size_t runEnd = i + 1;
+        while (runEnd < end && books[runEnd].getISBN() == books[i].getISBN()) ++runEnd;
+        if (runEnd - i > kInsertionRun) {
+            std::sort(books.begin() + i, books.begin() + runEnd);
+            i = runEnd;
+            continue;
+        }
+        for (size_t j = i + 1; j < runEnd; ++j) {
+            Book b = books[j];
+            size_t k = j;
+            for (; k > i && b < books[k - 1]; --k) books[k] = books[k - 1];
+            books[k] = b;
+        }
+        i = runEnd;
+    }
+}
+
+/**
+ * Tie-break every run of equal ISBNs, one range of runs per thread.
+ *
+ * The even cut points are first moved forward, serially, to the next run
+ * start (a binary search, since books are sorted by ISBN), so every run
+ * lies inside one thread's range and no two threads touch the same records.
+ */
+static void tieBreakPass(std::vector<Book>& books, unsigned threads) {
+    size_t n = books.size();
+    std::vector<size_t> cuts = {0};
+    for (unsigned t = 1; t < threads; ++t) {
+        size_t cut = std::max(n * t / threads, cuts.back());
+        if (cut > 0 && cut < n) {
+            cut = std::upper_bound(books.begin() + cut, books.end(), books[cut - 1].getISBN(),
+                                   [](size_t isbn, const Book& b) { return isbn < b.getISBN(); }) - books.begin();
+        }
+        cuts.push_back(cut);
+    }
+    cuts.push_back(n);
+    parallelFor(threads, threads, [&](unsigned, size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) sortRuns(books, cuts[t], cuts[t + 1]);
+    });
+}
+
+/**
+ * Parallel sort.
+ *
+ * Algorithm:
+ * 1. Small inputs: std::sort
+ * 2. Find the ISBN bytes that vary between books
+ * 3. One stable radix pass per such byte, least significant first,
+ *    ping-ponging between books and a scratch buffer
+ * 4. Move the result back into books if it ended in the scratch buffer
+ * 5. Tie-break pass within runs of equal ISBNs
+ */
+void parallelSortBooks(std::vector<Book>& books, unsigned threads) {
+    if (threads == 0) threads = 1;
+    if (books.size() < kRadixThreshold) {
+        std::sort(books.begin(), books.end());
+        return;
+    }
+
+    std::vector<int> bytes = activeBytes(books, threads);
+    std::vector<Book> scratch(books.size());
+    bool inScratch = false;
+    for (int byte : bytes) {
+        if (inScratch) radixPass(scratch, books, byte, threads);
+        else radixPass(books, scratch, byte, threads);
+        inScratch = !inScratch;
+    }
+    if (inScratch) books.swap(scratch);
+
+    tieBreakPass(books, threads);
+}
@@ -0,0 +1,40 @@
+/**
+ * book_sort.h
+ *
+ * Parallel catalog sort.
+ *
+ * Produces the same order as std::sort with Book::operator<, split across
+ * threads and linear in the number of books:
+ *
+ * 1. LSD radix sort on the 64-bit ISBN, one byte per pass. Every pass is a
+ *    parallel count over per-thread chunks, a prefix sum over
+ *    (bucket, thread), and a parallel stable scatter. Bytes that are the
+ *    same in every ISBN (e.g. the high bytes of 13-digit ISBNs) are found
+ *    up front and skipped, so real catalogs need 5-6 passes, not 8.
+ * 2. A parallel tie-break pass over each run of equal ISBNs, ordering it
+ *    by (type, language) as operator< does. Runs are usually a handful of
+ *    editions long and get an insertion sort; long runs get std::sort.
+ */
+
+#ifndef BOOK_SORT_H
+#define BOOK_SORT_H
+
+#include <vector>
+#include "book.h"
+
+/**
+ * Sort books by operator< on several threads.
+ *
+ * Small inputs fall back to std::sort, which wins below a few thousand
+ * books.
+ *
+ * Time complexity: O(p * n / threads) for p non-constant ISBN bytes, plus
+ *                  O(k log k) per run of k books sharing an ISBN
+ * Space complexity: O(n) scratch buffer
+ *
+ * @param books Books to sort in place
+ * @param threads Number of threads (0 is treated as 1)
+ */
+void parallelSortBooks(std::vector<Book>& books, unsigned threads);
+
+#endif // BOOK_SORT_H
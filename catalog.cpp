@@ -0,0 +1,141 @@
+/**
+ * catalog.cpp
+ *
+ * Implementation of the incrementally updatable catalog.
+ */
+
+#include "catalog.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <utility>
+
+/**
+ * Binary search a sorted vector for an exact book.
+ *
+ * operator< is a total order consistent with operator==, so lower_bound
+ * lands on the book if it is present at all.
+ */
+static bool sortedContains(const std::vector<Book>& v, const Book& book) {
+    auto it = std::lower_bound(v.begin(), v.end(), book);
+    return it != v.end() && *it == book;
+}
+
+/**
+ * Insert into a sorted vector, keeping it sorted.
+ */
+static void sortedInsert(std::vector<Book>& v, const Book& book) {
+    v.insert(std::lower_bound(v.begin(), v.end(), book), book);
+}
+
+/**
+ * Remove a book from a sorted vector if present.
+ *
+ * @return true if it was present
+ */
+static bool sortedErase(std::vector<Book>& v, const Book& book) {
+    auto it = std::lower_bound(v.begin(), v.end(), book);
+    if (it == v.end() || !(*it == book)) return false;
+    v.erase(it);
+    return true;
+}
+
+/**
+ * Constructor - sorts the initial books and drops duplicates.
+ */
+Catalog::Catalog(std::vector<Book> books) : main_(std::move(books)), size_(0) {
+    std::sort(main_.begin(), main_.end());
+    main_.erase(std::unique(main_.begin(), main_.end()), main_.end());
+    size_ = main_.size();
+}
+
+bool Catalog::inMain(const Book& book) const {
+    return sortedContains(main_, book) && !sortedContains(deletes_, book);
+}
+
+/**
+ * Membership in main and the deltas, bypassing the cache.
+ */
+bool Catalog::present(const Book& book) const {
+    return inMain(book) || sortedContains(inserts_, book);
+}
+
+/**
+ * Lookup: the cache first if there is one, then main and the deltas.
+ */
+bool Catalog::contains(const Book& book) const {
+    bool found;
+    if (cache_ && cache_->lookup(book, found)) return found;
+    found = present(book);
+    if (cache_) cache_->insert(book, found);
+    return found;
+}
+
+/**
+ * Insert: either cancel a pending delete of a main book, or add to the
+ * insert delta.
+ */
+bool Catalog::insert(const Book& book) {
+    if (present(book)) return false;
+    if (!sortedErase(deletes_, book)) sortedInsert(inserts_, book);
+    if (cache_) cache_->insert(book, true);  // The one result this update changed
+    ++size_;
+    compactIfNeeded();
+    return true;
+}
+
+/**
+ * Erase: either drop a pending insert, or record a delete of a main book.
+ */
+bool Catalog::erase(const Book& book) {
+    if (!present(book)) return false;
+    if (!sortedErase(inserts_, book)) sortedInsert(deletes_, book);
+    if (cache_) cache_->insert(book, false);
+    --size_;
+    compactIfNeeded();
+    return true;
+}
+
+/**
+ * Compact once the deltas exceed max(1024, 4 * sqrt(n)) entries.
+ *
+ * With that bound each update moves O(sqrt(n)) elements inside the
+ * deltas, and the O(n) merge happens once every O(sqrt(n)) updates.
+ */
+void Catalog::compactIfNeeded() {
+    size_t limit = std::max<size_t>(1024, static_cast<size_t>(4.0 * std::sqrt(static_cast<double>(main_.size()))));
+    if (pendingUpdates() > limit) compact();
+}
+
+/**
+ * Three-way linear merge: main minus deletes, plus inserts.
+ */
+void Catalog::compact() {
+    if (pendingUpdates() == 0) return;
+
+    std::vector<Book> merged;
+    merged.reserve(size_);
+    size_t i = 0, j = 0, d = 0;
+    while (i < main_.size() || j < inserts_.size()) {
+        bool takeMain = j == inserts_.size() || (i < main_.size() && main_[i] < inserts_[j]);
+        if (takeMain) {
+            const Book& b = main_[i++];
+            while (d < deletes_.size() && deletes_[d] < b) ++d;
+            if (d < deletes_.size() && deletes_[d] == b) continue;  // Deleted
+            merged.push_back(b);
+        } else {
+            merged.push_back(inserts_[j++]);
+        }
+    }
+    main_ = std::move(merged);
+    inserts_.clear();
+    deletes_.clear();
+}
+
+void Catalog::enableCache(const CacheSettings& settings) {
+    cache_ = std::make_unique<ResultCache>(settings);
+}
+
+CacheStats Catalog::cacheStats() const {
+    return cache_ ? cache_->stats() : CacheStats();
+}
@@ -0,0 +1,128 @@
+/**
+ * catalog.h
+ *
+ * In-memory book catalog that accepts inserts and deletes without
+ * re-sorting everything on each change.
+ *
+ * The catalog keeps three sorted vectors:
+ * - main:    the bulk of the books (deduplicated when the catalog is built)
+ * - inserts: books added since the last compaction, not present in main
+ * - deletes: books removed since the last compaction, present in main
+ *
+ * A lookup is at most three binary searches. Updates only touch the small
+ * delta vectors; once they grow past a threshold proportional to the
+ * square root of the catalog size, they are merged into main in one linear
+ * pass. That keeps the amortized cost of an update at O(sqrt(n)) element
+ * moves instead of an O(n log n) re-sort.
+ *
+ * An optional result cache (see result_cache.h) answers repeated lookups
+ * without searching. Every insert or erase overwrites the cached result of
+ * the book it changed, so the cache never serves a stale answer and the
+ * other hot entries survive the update.
+ *
+ * A Catalog is not thread-safe: updates and lookups must come from one
+ * thread, or be serialized by the caller.
+ */
+
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "book.h"
+#include "result_cache.h"
+
+/**
+ * Catalog - Sorted main array plus sorted insert/delete deltas.
+ *
+ * The catalog has set semantics: a book is either in it or not, no matter
+ * how many copies the initial vector contained.
+ */
+class Catalog {
+public:
+    /**
+     * Build a catalog from an initial set of books.
+     *
+     * @param books Books in any order (duplicates allowed)
+     */
+    explicit Catalog(std::vector<Book> books = {});
+
+    /**
+     * Add a book.
+     *
+     * @param book Book to add
+     * @return false if the book was already in the catalog
+     */
+    bool insert(const Book& book);
+
+    /**
+     * Remove a book.
+     *
+     * @param book Book to remove
+     * @return false if the book was not in the catalog
+     */
+    bool erase(const Book& book);
+
+    /**
+     * Exact-match lookup.
+     *
+     * Time complexity: O(log n + log d) for d pending updates
+     *
+     * @param book Book to look for
+     * @return true if the book is in the catalog
+     */
+    bool contains(const Book& book) const;
+
+    /**
+     * Merge pending inserts and deletes into the main array now.
+     *
+     * Time complexity: O(n + d)
+     */
+    void compact();
+
+    /**
+     * @return Number of distinct books in the catalog
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * @return Inserts plus deletes waiting to be merged
+     */
+    size_t pendingUpdates() const { return inserts_.size() + deletes_.size(); }
+
+    /**
+     * The compacted main array, sorted by operator<.
+     *
+     * Only reflects pending updates after compact().
+     *
+     * @return Reference to the main array
+     */
+    const std::vector<Book>& books() const { return main_; }
+
+    /**
+     * Cache lookup results from now on.
+     *
+     * @param settings Cache capacity
+     */
+    void enableCache(const CacheSettings& settings);
+
+    /**
+     * @return Cache counters (all zero without a cache). Only lookups
+     *         count; insert() and erase() check membership without the cache
+     */
+    CacheStats cacheStats() const;
+
+private:
+    bool inMain(const Book& book) const;
+    bool present(const Book& book) const;
+    void compactIfNeeded();
+
+    std::vector<Book> main_;
+    std::vector<Book> inserts_;
+    std::vector<Book> deletes_;
+    size_t size_;
+    std::unique_ptr<ResultCache> cache_;
+};
+
+#endif // CATALOG_H
@@ -0,0 +1,159 @@
+/**
+ * columnar.cpp
+ *
+ * Implementation of the structure-of-arrays book view and its SIMD scan
+ * kernels.
+ *
+ * Each kernel answers one question: "what is the next row at or after
+ * 'from' whose ISBN equals the target?". contains() calls it repeatedly and
+ * checks the id columns only for the rows it returns.
+ */
+
+#include "columnar.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COLUMNAR_X86 1
+#endif
+
+// ===== Scan kernels =====
+
+/**
+ * Portable kernel: one ISBN per iteration.
+ */
+static size_t findIsbnScalar(const uint64_t* col, size_t from, size_t n, uint64_t isbn) {
+    for (size_t i = from; i < n; ++i) {
+        if (col[i] == isbn) return i;
+    }
+    return n;
+}
+
+#ifdef COLUMNAR_X86
+
+/**
+ * SSE4.2 kernel: 8 ISBNs per iteration (four 2-lane compares OR-ed together),
+ * then a scalar pass over the block that matched and over the tail.
+ */
+__attribute__((target("sse4.2")))
+static size_t findIsbnSSE42(const uint64_t* col, size_t from, size_t n, uint64_t isbn) {
+    const __m128i target = _mm_set1_epi64x(static_cast<long long>(isbn));
+    size_t i = from;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_cmpeq_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(col + i)), target);
+        __m128i b = _mm_cmpeq_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(col + i + 2)), target);
+        __m128i c = _mm_cmpeq_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(col + i + 4)), target);
+        __m128i d = _mm_cmpeq_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(col + i + 6)), target);
+        __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        if (_mm_movemask_epi8(any) != 0) return findIsbnScalar(col, i, i + 8, isbn);
+    }
+    return findIsbnScalar(col, i, n, isbn);
+}
+
+/**
+ * AVX2 kernel: 16 ISBNs per iteration (four 4-lane compares OR-ed together),
+ * then a scalar pass over the block that matched and over the tail.
+ */
+__attribute__((target("avx2")))
+static size_t findIsbnAVX2(const uint64_t* col, size_t from, size_t n, uint64_t isbn) {
+    const __m256i target = _mm256_set1_epi64x(static_cast<long long>(isbn));
+    size_t i = from;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + i)), target);
+        __m256i b = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + i + 4)), target);
+        __m256i c = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + i + 8)), target);
+        __m256i d = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + i + 12)), target);
+        __m256i any = _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d));
+        if (!_mm256_testz_si256(any, any)) return findIsbnScalar(col, i, i + 16, isbn);
+    }
+    return findIsbnScalar(col, i, n, isbn);
+}
+
+#endif // COLUMNAR_X86
+
+// ===== Runtime dispatch =====
+
+bool scanKernelSupported(ScanKernel kernel) {
+    switch (kernel) {
+    case ScanKernel::Scalar:
+        return true;
+#ifdef COLUMNAR_X86
+    case ScanKernel::SSE42:
+        return __builtin_cpu_supports("sse4.2");
+    case ScanKernel::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+ScanKernel bestScanKernel() {
+    // Resolved once; the CPU does not change under us
+    static const ScanKernel best = scanKernelSupported(ScanKernel::AVX2) ? ScanKernel::AVX2
+                                 : scanKernelSupported(ScanKernel::SSE42) ? ScanKernel::SSE42
+                                 : ScanKernel::Scalar;
+    return best;
+}
+
+const char* scanKernelName(ScanKernel kernel) {
+    switch (kernel) {
+    case ScanKernel::SSE42: return "sse4.2";
+    case ScanKernel::AVX2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+// ===== BookColumns =====
+
+/**
+ * Split the books into columns.
+ */
+BookColumns::BookColumns(const std::vector<Book>& books) {
+    isbns_.reserve(books.size());
+    languageIds_.reserve(books.size());
+    typeIds_.reserve(books.size());
+    for (const auto& b : books) {
+        isbns_.push_back(b.getISBN());
+        languageIds_.push_back(b.getLanguageId());
+        typeIds_.push_back(b.getTypeId());
+    }
+}
+
+bool BookColumns::contains(const Book& key) const {
+    return contains(key, bestScanKernel());
+}
+
+/**
+ * Scan for a book.
+ *
+ * Algorithm:
+ * 1. Ask the kernel for the next row whose ISBN matches
+ * 2. If that row's type and language also match, we are done
+ * 3. Otherwise resume the scan just after it
+ */
+bool BookColumns::contains(const Book& key, ScanKernel kernel) const {
+    size_t (*findIsbn)(const uint64_t*, size_t, size_t, uint64_t) = findIsbnScalar;
+#ifdef COLUMNAR_X86
+    if (kernel == ScanKernel::AVX2) findIsbn = findIsbnAVX2;
+    else if (kernel == ScanKernel::SSE42) findIsbn = findIsbnSSE42;
+#endif
+
+    const uint64_t* col = isbns_.data();
+    size_t n = isbns_.size();
+    for (size_t i = findIsbn(col, 0, n, key.getISBN()); i < n; i = findIsbn(col, i + 1, n, key.getISBN())) {
+        if (typeIds_[i] == key.getTypeId() && languageIds_[i] == key.getLanguageId()) return true;
+    }
+    return false;
+}
+
+/**
+ * Columnar search implementation.
+ *
+ * Translates language and type to their interned ids (without interning new
+ * strings) and scans the columns once.
+ */
+bool columnarSearch(const BookColumns& columns, std::string_view lang, std::string_view type, size_t isbn) {
+    Book key;
+    if (!encodeBook(lang, type, isbn, key)) return false;
+    return columns.contains(key);
+}
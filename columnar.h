@@ -0,0 +1,113 @@
+/**
+ * columnar.h
+ *
+ * Structure-of-arrays view of a books vector for fast linear scans.
+ *
+ * The catalog is split into three contiguous columns: ISBNs (uint64_t),
+ * language ids (uint32_t) and type ids (uint16_t). A scan streams only the
+ * ISBN column through SIMD compare kernels and looks at the id columns for
+ * the rare candidate rows, so it runs at memory bandwidth instead of being
+ * bound by per-element getter calls.
+ *
+ * The kernel is picked at runtime from what the CPU supports (AVX2, then
+ * SSE4.2, then a portable scalar loop). Like linearSearch, no ordering of
+ * the books is required.
+ */
+
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "book.h"
+
+/**
+ * ScanKernel - Implementations of the ISBN column scan.
+ */
+enum class ScanKernel {
+    Scalar,  // Portable loop, always available
+    SSE42,   // 2 ISBNs per compare
+    AVX2     // 4 ISBNs per compare
+};
+
+/**
+ * Check whether the running CPU can execute a kernel.
+ *
+ * @param kernel Kernel to check
+ * @return true if kernel may be passed to BookColumns::contains()
+ */
+bool scanKernelSupported(ScanKernel kernel);
+
+/**
+ * @return The fastest kernel supported by the running CPU
+ */
+ScanKernel bestScanKernel();
+
+/**
+ * @return Human-readable kernel name ("scalar", "sse4.2", "avx2")
+ */
+const char* scanKernelName(ScanKernel kernel);
+
+/**
+ * BookColumns - Column-oriented copy of a books vector.
+ */
+class BookColumns {
+public:
+    /**
+     * Build the columns.
+     *
+     * Time complexity: O(n)
+     * Space complexity: 14 bytes per book
+     *
+     * @param books Books in any order
+     */
+    explicit BookColumns(const std::vector<Book>& books);
+
+    /**
+     * Exact-match scan using the best kernel for this CPU.
+     *
+     * @param key Book to look for
+     * @return true if a book equal to key exists
+     */
+    bool contains(const Book& key) const;
+
+    /**
+     * Exact-match scan using a specific kernel.
+     *
+     * @param key Book to look for
+     * @param kernel Kernel to use; must satisfy scanKernelSupported()
+     * @return true if a book equal to key exists
+     */
+    bool contains(const Book& key, ScanKernel kernel) const;
+
+    /**
+     * @return Number of rows
+     */
+    size_t size() const { return isbns_.size(); }
+
+private:
+    std::vector<uint64_t> isbns_;
+    std::vector<uint32_t> languageIds_;
+    std::vector<uint16_t> typeIds_;
+};
+
+/**
+ * Columnar linear search.
+ *
+ * Same contract as linearSearch, answered by a SIMD scan over a prebuilt
+ * BookColumns view.
+ *
+ * Time complexity: O(n)
+ * Space complexity: O(1)
+ *
+ * @param columns Column view of the books
+ * @param lang Target language to match
+ * @param type Target type to match
+ * @param isbn Target ISBN to match
+ * @return true if a book matching ALL three criteria is found, false otherwise
+ */
+bool columnarSearch(const BookColumns& columns, std::string_view lang, std::string_view type, size_t isbn);
+
+#endif // COLUMNAR_H
@@ -0,0 +1,377 @@
+/**
+ * compressed_catalog.cpp
+ *
+ * Implementation of the block-compressed catalog and its unpacking kernels.
+ *
+ * Each kernel answers one question for a packed block: "which records have
+ * ISBN offset equal to the target?". Offsets are sorted, so the answer is
+ * one contiguous range [first, last), and the kernel stops decoding at the
+ * first row that starts past the target. contains() then checks the edition
+ * codes of that range only.
+ */
+
+#include "compressed_catalog.h"
+#include "search_kernels.h"
+#include <algorithm>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COMPRESSED_X86 1
+#endif
+
+static_assert(CompressedCatalog::kBlockSize % CompressedCatalog::kLanes == 0 && CompressedCatalog::kBlockSize <= UINT16_MAX,
+              "a block is whole rows, counted in 16 bits");
+
+/** Order on plain 64-bit keys, for searching the skip index. */
+struct KeyOrder {
+    using Key = uint64_t;
+    static uint64_t key(uint64_t k) { return k; }
+    static bool less(uint64_t a, uint64_t b) { return a < b; }
+};
+
+/** Range of records [first, last) whose offset matched; first == last if none. */
+using MatchRange = std::pair<size_t, size_t>;
+
+/**
+ * Bits needed to store x (0 for x == 0).
+ */
+static inline unsigned bitsFor(uint64_t x) {
+    return x == 0 ? 0 : 64 - static_cast<unsigned>(__builtin_clzll(x));
+}
+
+/**
+ * Fold the match bits of one row (bit l: lane l equals the target) into the
+ * running range, ignoring padding records past count.
+ */
+static inline void noteMatches(unsigned eq, size_t row, size_t count, MatchRange& range) {
+    size_t base = row * CompressedCatalog::kLanes;
+    if (base + CompressedCatalog::kLanes > count) eq &= (1u << (count - base)) - 1;
+    if (eq == 0) return;
+    if (range.first == range.second) range.first = base + __builtin_ctz(eq);
+    range.second = base + 32 - __builtin_clz(eq);
+}
+
+// ===== Unpacking kernels =====
+
+/**
+ * Unpack row `row` of a delta block and add it to the lane accumulators, so
+ * they hold the row's offsets afterwards.
+ */
+static inline void unpackRow(const uint32_t* words, unsigned width, size_t row, uint32_t* acc) {
+    if (width == 0) return;
+    uint32_t mask = width == 32 ? ~0u : (1u << width) - 1;
+    size_t bit = row * width;
+    const uint32_t* lo = words + (bit / 32) * CompressedCatalog::kLanes;
+    unsigned s = bit % 32;
+    for (size_t l = 0; l < CompressedCatalog::kLanes; ++l) {
+        uint32_t v = lo[l] >> s;
+        if (s + width > 32) v |= lo[l + CompressedCatalog::kLanes] << (32 - s);
+        acc[l] += v & mask;
+    }
+}
+
+/**
+ * Portable kernel: one lane at a time.
+ */
+static MatchRange findOffsetScalar(const uint32_t* words, unsigned width, size_t count, uint32_t target) {
+    uint32_t acc[CompressedCatalog::kLanes] = {};
+    MatchRange range(0, 0);
+    for (size_t row = 0; row * CompressedCatalog::kLanes < count; ++row) {
+        unpackRow(words, width, row, acc);
+        unsigned eq = 0;
+        for (size_t l = 0; l < CompressedCatalog::kLanes; ++l) eq |= static_cast<unsigned>(acc[l] == target) << l;
+        noteMatches(eq, row, count, range);
+        if (acc[0] > target) break;  // Lane 0 is the row's smallest offset
+    }
+    return range;
+}
+
+#ifdef COMPRESSED_X86
+
+/**
+ * SSE4.2 kernel: the 8 lanes as two 4-lane halves.
+ */
+__attribute__((target("sse4.2")))
+static MatchRange findOffsetSSE42(const uint32_t* words, unsigned width, size_t count, uint32_t target) {
+    const __m128i mask = _mm_set1_epi32(static_cast<int>(width == 32 ? ~0u : (1u << width) - 1));
+    const __m128i tgt = _mm_set1_epi32(static_cast<int>(target));
+    __m128i lo = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+    MatchRange range(0, 0);
+    for (size_t row = 0; row * CompressedCatalog::kLanes < count; ++row) {
+        if (width != 0) {
+            size_t bit = row * width;
+            const __m128i* w = reinterpret_cast<const __m128i*>(words + (bit / 32) * CompressedCatalog::kLanes);
+            unsigned s = bit % 32;
+            __m128i right = _mm_cvtsi32_si128(static_cast<int>(s));
+            __m128i vlo = _mm_srl_epi32(_mm_loadu_si128(w), right);
+            __m128i vhi = _mm_srl_epi32(_mm_loadu_si128(w + 1), right);
+            if (s + width > 32) {
+                __m128i left = _mm_cvtsi32_si128(static_cast<int>(32 - s));
+                vlo = _mm_or_si128(vlo, _mm_sll_epi32(_mm_loadu_si128(w + 2), left));
+                vhi = _mm_or_si128(vhi, _mm_sll_epi32(_mm_loadu_si128(w + 3), left));
+            }
+            lo = _mm_add_epi32(lo, _mm_and_si128(vlo, mask));
+            hi = _mm_add_epi32(hi, _mm_and_si128(vhi, mask));
+        }
+        unsigned eq = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(lo, tgt))))
+                    | static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(hi, tgt)))) << 4;
+        noteMatches(eq, row, count, range);
+        if (static_cast<uint32_t>(_mm_cvtsi128_si32(lo)) > target) break;
+    }
+    return range;
+}
+
+/**
+ * AVX2 kernel: all 8 lanes per shift/mask/add.
+ */
+__attribute__((target("avx2")))
+static MatchRange findOffsetAVX2(const uint32_t* words, unsigned width, size_t count, uint32_t target) {
+    const __m256i mask = _mm256_set1_epi32(static_cast<int>(width == 32 ? ~0u : (1u << width) - 1));
+    const __m256i tgt = _mm256_set1_epi32(static_cast<int>(target));
+    __m256i acc = _mm256_setzero_si256();
+    MatchRange range(0, 0);
+    for (size_t row = 0; row * CompressedCatalog::kLanes < count; ++row) {
+        if (width != 0) {
+            size_t bit = row * width;
+            const __m256i* w = reinterpret_cast<const __m256i*>(words + (bit / 32) * CompressedCatalog::kLanes);
+            unsigned s = bit % 32;
+            __m256i v = _mm256_srl_epi32(_mm256_loadu_si256(w), _mm_cvtsi32_si128(static_cast<int>(s)));
+            if (s + width > 32) {
+                v = _mm256_or_si256(v, _mm256_sll_epi32(_mm256_loadu_si256(w + 1), _mm_cvtsi32_si128(static_cast<int>(32 - s))));
+            }
+            acc = _mm256_add_epi32(acc, _mm256_and_si256(v, mask));
+        }
+        unsigned eq = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(acc, tgt))));
+        noteMatches(eq, row, count, range);
+        if (static_cast<uint32_t>(_mm256_cvtsi256_si32(acc)) > target) break;
+    }
+    return range;
+}
+
+#endif // COMPRESSED_X86
+
+// ===== CompressedCatalog =====
+
+/**
+ * Pack a (type, language) pair into one dictionary key.
+ */
+static inline uint64_t editionOf(const Book& book) {
+    return (static_cast<uint64_t>(book.getTypeId()) << 32) | book.getLanguageId();
+}
+
+CompressedCatalog::CompressedCatalog(const std::vector<Book>& books) {
+    CompressedCatalogBuilder builder;
+    for (const auto& b : books) builder.add(b);
+    *this = builder.finish();
+}
+
+bool CompressedCatalog::contains(const Book& key) const {
+    return locate(key, bestScanKernel()) != npos;
+}
+
+bool CompressedCatalog::contains(const Book& key, ScanKernel kernel) const {
+    return locate(key, kernel) != npos;
+}
+
+size_t CompressedCatalog::find(const Book& key) const {
+    return locate(key, bestScanKernel());
+}
+
+/**
+ * Locate a book.
+ *
+ * Algorithm:
+ * 1. Map its edition to a code; an edition no record has cannot match
+ * 2. Find the last block whose first ISBN is below the target in the skip
+ *    index. The target can only be there, or (as a run of editions
+ *    straddling the boundary) in the following blocks that start with it
+ * 3. Decode each candidate block up to the target and check the codes of
+ *    the records whose ISBN matched
+ */
+size_t CompressedCatalog::locate(const Book& key, ScanKernel kernel) const {
+    auto edition = editionCodes_.find(editionOf(key));
+    if (edition == editionCodes_.end()) return npos;
+    uint64_t isbn = key.getISBN();
+    size_t b = branchlessLowerBound<KeyOrder>(firstKeys_.begin(), firstKeys_.end(), isbn) - firstKeys_.begin();
+    for (b = b > 0 ? b - 1 : 0; b < firstKeys_.size() && firstKeys_[b] <= isbn; ++b) {
+        uint64_t offset = isbn - firstKeys_[b];
+        if (offset > UINT32_MAX) continue;  // Past the end of block b
+        size_t i = blockFind(b, static_cast<uint32_t>(offset), edition->second, kernel);
+        if (i != npos) return blocks_[b].position + i;
+    }
+    return npos;
+}
+
+/**
+ * Words of packed deltas in a block: each lane holds one delta per row of
+ * the block, width bits each.
+ */
+size_t CompressedCatalog::deltaWords(const Block& block) {
+    size_t rows = (block.count + kLanes - 1) / kLanes;
+    return (rows * block.width + 31) / 32 * kLanes;
+}
+
+/**
+ * Index within block b of the first record with this offset and edition
+ * code, or npos.
+ */
+size_t CompressedCatalog::blockFind(size_t b, uint32_t offset, uint32_t code, ScanKernel kernel) const {
+    const Block& block = blocks_[b];
+    MatchRange (*findOffset)(const uint32_t*, unsigned, size_t, uint32_t) = findOffsetScalar;
+#ifdef COMPRESSED_X86
+    if (kernel == ScanKernel::AVX2) findOffset = findOffsetAVX2;
+    else if (kernel == ScanKernel::SSE42) findOffset = findOffsetSSE42;
+#endif
+    MatchRange range = findOffset(payload_.data() + block.payload, block.width, block.count, offset);
+    for (size_t i = range.first; i < range.second; ++i) {
+        if (codeAt(block, i) == code) return i;
+    }
+    return npos;
+}
+
+/**
+ * Edition code of record i of a block. Codes follow the block's offsets;
+ * the padding word at the end of payload_ makes the two-word read safe.
+ */
+uint32_t CompressedCatalog::codeAt(const Block& block, size_t i) const {
+    if (block.codeWidth == 0) return 0;
+    size_t codes = block.payload + deltaWords(block);
+    size_t bit = i * block.codeWidth;
+    const uint32_t* w = payload_.data() + codes + bit / 32;
+    uint64_t two = w[0] | static_cast<uint64_t>(w[1]) << 32;
+    return static_cast<uint32_t>((two >> (bit % 32)) & ((uint64_t(1) << block.codeWidth) - 1));
+}
+
+/**
+ * Decode all offsets of a block (count of them) into offsets.
+ */
+void CompressedCatalog::decodeOffsets(const Block& block, uint32_t* offsets) const {
+    const uint32_t* words = payload_.data() + block.payload;
+    uint32_t acc[kLanes] = {};
+    for (size_t row = 0; row * kLanes < block.count; ++row) {
+        unpackRow(words, block.width, row, acc);
+        for (size_t l = 0; l < kLanes && row * kLanes + l < block.count; ++l) offsets[row * kLanes + l] = acc[l];
+    }
+}
+
+/**
+ * Rebuild record i of block b from its decoded offset.
+ */
+Book CompressedCatalog::bookAt(size_t b, size_t i, uint32_t offset) const {
+    uint64_t edition = editions_[codeAt(blocks_[b], i)];
+    return Book(firstKeys_[b] + offset, static_cast<uint32_t>(edition), static_cast<uint16_t>(edition >> 32));
+}
+
+std::vector<Book> CompressedCatalog::decode() const {
+    std::vector<Book> books;
+    books.reserve(size_);
+    forEach([&books](const Book& b) { books.push_back(b); });
+    return books;
+}
+
+size_t CompressedCatalog::memoryBytes() const {
+    return firstKeys_.size() * sizeof(uint64_t) + blocks_.size() * sizeof(Block) + payload_.size() * sizeof(uint32_t)
+         + editions_.size() * (2 * sizeof(uint64_t) + sizeof(uint32_t));
+}
+
+// ===== CompressedCatalogBuilder =====
+
+void CompressedCatalogBuilder::add(const Book& book) {
+    if (!pending_.empty() && book.getISBN() - pending_[0].getISBN() > UINT32_MAX) flush();
+    auto inserted = catalog_.editionCodes_.emplace(editionOf(book), static_cast<uint32_t>(catalog_.editions_.size()));
+    if (inserted.second) catalog_.editions_.push_back(editionOf(book));
+    if (pending_.empty()) pending_.reserve(CompressedCatalog::kBlockSize);
+    pending_.push_back(book);
+    if (pending_.size() == CompressedCatalog::kBlockSize) flush();
+}
+
+/**
+ * Encode the pending records as one block.
+ *
+ * Algorithm:
+ * 1. Offsets from the block's first ISBN (all below 2^32, see add()).
+ *    Padding records up to a whole row repeat the last offset
+ * 2. Take each offset's delta to the record kLanes back and pack lane l's
+ *    deltas as one bit stream in word column l
+ * 3. Pack the edition codes after them
+ */
+void CompressedCatalogBuilder::flush() {
+    const size_t lanes = CompressedCatalog::kLanes;
+    size_t n = pending_.size();
+    if (n == 0) return;
+    std::vector<uint32_t>& payload = catalog_.payload_;
+    CompressedCatalog::Block block;
+    block.payload = payload.size();
+    block.position = catalog_.size_;
+    block.count = static_cast<uint16_t>(n);
+    uint64_t first = pending_[0].getISBN();
+    size_t padded = (n + lanes - 1) / lanes * lanes;
+
+    // Step 1
+    uint32_t offsets[CompressedCatalog::kBlockSize];
+    for (size_t i = 0; i < padded; ++i) offsets[i] = static_cast<uint32_t>(pending_[std::min(i, n - 1)].getISBN() - first);
+
+    // Step 2
+    uint32_t deltas[CompressedCatalog::kBlockSize];
+    uint32_t largest = 0;
+    for (size_t i = 0; i < padded; ++i) {
+        deltas[i] = offsets[i] - (i >= lanes ? offsets[i - lanes] : 0);
+        largest = std::max(largest, deltas[i]);
+    }
+    unsigned width = bitsFor(largest);
+    block.width = static_cast<uint8_t>(width);
+    payload.resize(payload.size() + CompressedCatalog::deltaWords(block), 0);
+    uint32_t* words = payload.data() + block.payload;
+    for (size_t row = 0; row < padded / lanes && width > 0; ++row) {
+        size_t bit = row * width;
+        uint32_t* lo = words + (bit / 32) * lanes;
+        unsigned s = bit % 32;
+        for (size_t l = 0; l < lanes; ++l) {
+            uint64_t v = deltas[row * lanes + l];
+            lo[l] |= static_cast<uint32_t>(v << s);
+            if (s + width > 32) lo[l + lanes] |= static_cast<uint32_t>(v >> (32 - s));
+        }
+    }
+
+    // Step 3
+    uint32_t largestCode = 0;
+    for (const auto& b : pending_) largestCode = std::max(largestCode, catalog_.editionCodes_.at(editionOf(b)));
+    unsigned codeWidth = bitsFor(largestCode);
+    block.codeWidth = static_cast<uint8_t>(codeWidth);
+    size_t codes = payload.size();
+    payload.resize(codes + (n * codeWidth + 31) / 32, 0);
+    for (size_t i = 0; i < n && codeWidth > 0; ++i) {
+        uint64_t code = catalog_.editionCodes_.at(editionOf(pending_[i]));
+        size_t bit = i * codeWidth;
+        payload[codes + bit / 32] |= static_cast<uint32_t>(code << (bit % 32));
+        if (bit % 32 + codeWidth > 32) payload[codes + bit / 32 + 1] |= static_cast<uint32_t>(code >> (32 - bit % 32));
+    }
+
+    catalog_.firstKeys_.push_back(first);
+    catalog_.blocks_.push_back(block);
+    catalog_.size_ += n;
+    pending_.clear();
+}
+
+CompressedCatalog CompressedCatalogBuilder::finish() {
+    flush();
+    catalog_.payload_.push_back(0);  // Padding for codeAt()'s two-word read
+    catalog_.payload_.shrink_to_fit();
+    CompressedCatalog done = std::move(catalog_);
+    catalog_ = CompressedCatalog();
+    return done;
+}
+
+/**
+ * Compressed search implementation.
+ *
+ * Translates language and type to their interned ids (without interning new
+ * strings) and runs one lookup on the catalog.
+ */
+bool compressedSearch(const CompressedCatalog& catalog, std::string_view lang, std::string_view type, size_t isbn) {
+    Book key;
+    if (!encodeBook(lang, type, isbn, key)) return false;
+    return catalog.contains(key);
+}
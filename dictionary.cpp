@@ -0,0 +1,74 @@
+/**
+ * dictionary.cpp
+ *
+ * Implementation of the string interning dictionary and the process-wide
+ * language/type dictionaries.
+ */
+
+#include "dictionary.h"
+
+/** Arena block size: a dictionary holds a few short strings, so one small block usually suffices. */
+static const size_t kArenaBlockBytes = 4096;
+
+/**
+ * Constructor - interns the reserved strings in order so they get ids 0..k-1.
+ */
+StringDictionary::StringDictionary(std::initializer_list<const char*> reserved) : arena_(kArenaBlockBytes) {
+    for (const char* s : reserved) intern(s);
+}
+
+/**
+ * Intern a string.
+ *
+ * The string is copied into the arena once; names_ and the map key are
+ * views of that copy, so lookups with a string_view never allocate.
+ */
+uint32_t StringDictionary::intern(std::string_view s) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = ids_.find(s);
+    if (it != ids_.end()) return it->second;
+
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    std::string_view stored = arena_.store(s);
+    names_.push_back(stored);
+    ids_.emplace(stored, id);
+    return id;
+}
+
+/**
+ * Look up a string without interning it.
+ */
+uint32_t StringDictionary::find(std::string_view s) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = ids_.find(s);
+    return it == ids_.end() ? npos : it->second;
+}
+
+/**
+ * Get the string stored for an id.
+ */
+std::string_view StringDictionary::name(uint32_t id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return names_[id];
+}
+
+/**
+ * Number of interned strings.
+ */
+size_t StringDictionary::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return names_.size();
+}
+
+// ===== Process-wide dictionaries =====
+
+StringDictionary& languageDictionary() {
+    static StringDictionary dict;
+    return dict;
+}
+
+StringDictionary& typeDictionary() {
+    // Order must match BookType in book.h
+    static StringDictionary dict{"new", "used", "digital"};
+    return dict;
+}
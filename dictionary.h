@@ -0,0 +1,100 @@
+/**
+ * dictionary.h
+ *
+ * String interning dictionary used to encode the language and type fields of
+ * a Book as small integer ids.
+ *
+ * Every distinct string is stored exactly once and mapped to a dense id
+ * (0, 1, 2, ...) in first-seen order. Books store only the id, so comparing
+ * two books never touches string data and a record stays 16 bytes.
+ *
+ * The string bytes live in a StringArena (see arena.h): interning a new
+ * string is a copy into the current arena block rather than a heap
+ * allocation of its own, and all of them are released together.
+ * 
+ * The dictionary is safe to use from several threads: interning and lookups
+ * are serialized by an internal mutex, and views returned by name() stay
+ * valid for the lifetime of the dictionary.
+ */
+
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "arena.h"
+
+/**
+ * StringDictionary - Bidirectional mapping between strings and dense ids.
+ */
+class StringDictionary {
+public:
+    /** Id returned by find() when a string has never been interned. */
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    /**
+     * Constructor - optionally pre-interns a list of strings so that they
+     * receive the ids 0, 1, 2, ... in the order given.
+     *
+     * @param reserved Strings to intern up front
+     */
+    explicit StringDictionary(std::initializer_list<const char*> reserved = {});
+
+    StringDictionary(const StringDictionary&) = delete;
+    StringDictionary& operator=(const StringDictionary&) = delete;
+
+    /**
+     * Get the id for a string, adding it to the dictionary if necessary.
+     *
+     * @param s The string to intern
+     * @return The id assigned to s
+     */
+    uint32_t intern(std::string_view s);
+
+    /**
+     * Look up the id of a string without adding it.
+     *
+     * @param s The string to look up
+     * @return The id of s, or npos if s has never been interned
+     */
+    uint32_t find(std::string_view s) const;
+
+    /**
+     * Get the string for an id.
+     *
+     * @param id An id previously returned by intern()
+     * @return View of the stored string (stable for the dictionary's lifetime)
+     */
+    std::string_view name(uint32_t id) const;
+
+    /**
+     * @return Number of distinct strings interned so far
+     */
+    size_t size() const;
+
+private:
+    mutable std::mutex mutex_;
+    StringArena arena_;                                    // Bytes of every interned string
+    std::vector<std::string_view> names_;                  // id -> string (views point into arena_)
+    std::unordered_map<std::string_view, uint32_t> ids_;   // string -> id (views point into arena_)
+};
+
+/**
+ * Process-wide dictionary for book languages.
+ */
+StringDictionary& languageDictionary();
+
+/**
+ * Process-wide dictionary for book types.
+ *
+ * The well-known types are pre-interned so that their ids match BookType:
+ * "new" = 0, "used" = 1, "digital" = 2. Any other type string gets an id >= 3.
+ */
+StringDictionary& typeDictionary();
+
+#endif // DICTIONARY_H
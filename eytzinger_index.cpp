@@ -0,0 +1,93 @@
+/**
+ * eytzinger_index.cpp
+ *
+ * Implementation of the Eytzinger-ordered ISBN index.
+ */
+
+#include "eytzinger_index.h"
+
+/**
+ * Build the index.
+ *
+ * Algorithm:
+ * 1. Collect the distinct ISBNs and the position where each one starts
+ * 2. Fill the tree by an in-order traversal of the implicit BFS tree, which
+ *    places the i-th smallest ISBN at the i-th node visited
+ */
+EytzingerIndex::EytzingerIndex(const std::vector<Book>& books) : books_(&books), n_(0) {
+    // Step 1: distinct ISBNs in sorted order, with their first position
+    std::vector<uint64_t> sortedKeys;
+    std::vector<size_t> firstPos;
+    for (size_t i = 0; i < books.size(); ++i) {
+        if (i == 0 || books[i].getISBN() != books[i - 1].getISBN()) {
+            sortedKeys.push_back(books[i].getISBN());
+            firstPos.push_back(i);
+        }
+    }
+    n_ = sortedKeys.size();
+
+    // 64-byte aligned so that the 8 nodes 8k..8k+7 share one cache line
+    size_t bytes = ((n_ + 1) * sizeof(uint64_t) + 63) / 64 * 64;
+    keys_.reset(static_cast<uint64_t*>(std::aligned_alloc(64, bytes)));
+    keys_[0] = 0;
+    positions_.assign(n_ + 1, books.size());
+
+    // Step 2: iterative in-order traversal of nodes 1..n_
+    size_t next = 0;
+    size_t k = 1;
+    std::vector<size_t> stack;
+    while (k <= n_ || !stack.empty()) {
+        while (k <= n_) {
+            stack.push_back(k);
+            k = 2 * k;
+        }
+        k = stack.back();
+        stack.pop_back();
+        keys_[k] = sortedKeys[next];
+        positions_[k] = firstPos[next];
+        ++next;
+        k = 2 * k + 1;
+    }
+}
+
+/**
+ * Branch-free descent.
+ *
+ * Each step moves to child 2k (key >= isbn) or 2k+1 (key < isbn). When k
+ * falls off the tree, the answer is the last node where we went left, which
+ * is recovered by stripping the trailing 1-bits (right turns) plus one more
+ * bit from k. If we never went left, k becomes 0 and nothing is >= isbn.
+ */
+size_t EytzingerIndex::lowerBound(size_t isbn) const {
+    const uint64_t* keys = keys_.get();
+    size_t k = 1;
+    while (k <= n_) {
+        __builtin_prefetch(keys + 8 * k);  // Node 8k's cache line: three levels down
+        k = 2 * k + (keys[k] < isbn);
+    }
+    k >>= __builtin_ctzll(~k) + 1;
+    return k == 0 ? books_->size() : positions_[k];
+}
+
+/**
+ * Exact-match lookup: one descent, then a short scan over the ISBN's run.
+ */
+bool EytzingerIndex::contains(const Book& key) const {
+    const std::vector<Book>& books = *books_;
+    for (size_t i = lowerBound(key.getISBN()); i < books.size() && books[i].getISBN() == key.getISBN(); ++i) {
+        if (books[i] == key) return true;
+    }
+    return false;
+}
+
+/**
+ * Eytzinger search implementation.
+ *
+ * Translates language and type to their interned ids (without interning new
+ * strings) and runs one lookup on the index.
+ */
+bool eytzingerSearch(const EytzingerIndex& index, std::string_view lang, std::string_view type, size_t isbn) {
+    Book key;
+    if (!encodeBook(lang, type, isbn, key)) return false;
+    return index.contains(key);
+}
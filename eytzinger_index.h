@@ -0,0 +1,99 @@
+/**
+ * eytzinger_index.h
+ *
+ * Cache-friendly ISBN index for the binary search path.
+ *
+ * The distinct ISBNs of a sorted books vector are copied into a separate
+ * array laid out in Eytzinger (BFS) order: the root at index 1, and the
+ * children of node k at 2k and 2k+1. A descent therefore walks the array
+ * from left to right, the top levels of the tree share a handful of hot
+ * cache lines, and the 8 great-grandchildren of node k occupy exactly one
+ * 64-byte line, which is prefetched three levels ahead.
+ *
+ * Only the 8-byte keys are touched during the descent. Each node also
+ * records where its ISBN starts in the books vector, so the full records
+ * are read only once a candidate has been found.
+ */
+
+#ifndef EYTZINGER_INDEX_H
+#define EYTZINGER_INDEX_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "book.h"
+
+/**
+ * EytzingerIndex - BFS-ordered ISBN keys pointing back into a sorted vector.
+ *
+ * The books vector passed to the constructor must be sorted by operator<,
+ * and must outlive the index without being modified.
+ */
+class EytzingerIndex {
+public:
+    /**
+     * Build the index.
+     *
+     * Time complexity: O(n)
+     * Space complexity: O(u) for u distinct ISBNs (8-byte key + 8-byte position each)
+     *
+     * @param books Vector of SORTED books
+     */
+    explicit EytzingerIndex(const std::vector<Book>& books);
+
+    /**
+     * Find the first book whose ISBN is >= isbn.
+     *
+     * @param isbn Target ISBN
+     * @return Index into the books vector, or books.size() if every ISBN is smaller
+     */
+    size_t lowerBound(size_t isbn) const;
+
+    /**
+     * Exact-match lookup on an encoded book.
+     *
+     * Descends the ISBN tree once, then scans the (usually very short) run of
+     * books sharing that ISBN for a matching type and language.
+     *
+     * @param key Book to look for
+     * @return true if a book equal to key exists
+     */
+    bool contains(const Book& key) const;
+
+    /**
+     * @return Number of distinct ISBNs in the tree
+     */
+    size_t size() const { return n_; }
+
+private:
+    struct FreeDeleter {
+        void operator()(void* p) const { std::free(p); }
+    };
+
+    const std::vector<Book>* books_;
+    size_t n_;                                      // Number of tree nodes (distinct ISBNs)
+    std::unique_ptr<uint64_t[], FreeDeleter> keys_; // keys_[1..n_] in BFS order, 64-byte aligned
+    std::vector<size_t> positions_;                 // positions_[k] = first index of keys_[k] in *books_
+};
+
+/**
+ * Eytzinger search.
+ *
+ * Same contract as binarySearch, but the ISBN descent runs over a prebuilt
+ * EytzingerIndex instead of the books vector.
+ *
+ * Time complexity: O(log n)
+ * Space complexity: O(1)
+ *
+ * @param index Prebuilt index over the SORTED books
+ * @param lang Target language to match
+ * @param type Target type to match
+ * @param isbn Target ISBN to match
+ * @return true if a book matching ALL three criteria is found, false otherwise
+ */
+bool eytzingerSearch(const EytzingerIndex& index, std::string_view lang, std::string_view type, size_t isbn);
+
+#endif // EYTZINGER_INDEX_H
@@ -0,0 +1,90 @@
+/**
+ * hash_index.cpp
+ *
+ * Implementation of the open-addressing hash index over books.
+ */
+
+#include "hash_index.h"
+#include <utility>
+
+/**
+ * Hash the packed (ISBN, type, language) key.
+ *
+ * The three fields are folded into one 64-bit word and passed through the
+ * 64-bit finalizer from MurmurHash3, which spreads consecutive ISBNs over
+ * the whole table.
+ */
+uint64_t BookHashIndex::hash(const Book& b) {
+    uint64_t h = b.getISBN();
+    h ^= ((static_cast<uint64_t>(b.getTypeId()) << 32) | b.getLanguageId()) * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * Build the table.
+ *
+ * Algorithm:
+ * 1. Pick capacity = smallest power of two with n / capacity <= maxLoad
+ * 2. For each book, probe linearly from hash(book) until an empty slot or an
+ *    equal book is found; store it in the empty slot
+ */
+BookHashIndex::BookHashIndex(const std::vector<Book>& books, double maxLoad) : mask_(0), size_(0) {
+    if (maxLoad <= 0.0 || maxLoad >= 1.0) maxLoad = 0.5;
+
+    size_t capacity = 16;
+    while (static_cast<double>(books.size()) > maxLoad * static_cast<double>(capacity)) capacity *= 2;
+
+    slots_.assign(capacity, Book(0, 0, kEmptyType));
+    mask_ = capacity - 1;
+
+    for (const auto& b : books) {
+        size_t i = hash(b) & mask_;
+        while (slots_[i].getTypeId() != kEmptyType) {
+            if (slots_[i] == b) break;  // Duplicate book, already indexed
+            i = (i + 1) & mask_;
+        }
+        if (slots_[i].getTypeId() == kEmptyType) {
+            slots_[i] = b;
+            ++size_;
+        }
+    }
+}
+
+/**
+ * Restore a saved slot array as-is.
+ */
+BookHashIndex::BookHashIndex(std::vector<Book> slots, size_t size)
+    : slots_(std::move(slots)), mask_(slots_.size() - 1), size_(size) {}
+
+/**
+ * Probe for a book.
+ *
+ * Walks the probe sequence until the book or an empty slot is found. The
+ * load factor bound guarantees an empty slot exists, so the loop terminates.
+ */
+bool BookHashIndex::contains(const Book& key) const {
+    size_t i = hash(key) & mask_;
+    while (true) {
+        const Book& s = slots_[i];
+        if (s == key) return true;
+        if (s.getTypeId() == kEmptyType) return false;
+        i = (i + 1) & mask_;
+    }
+}
+
+/**
+ * Hash index search implementation.
+ *
+ * Translates language and type to their interned ids (without interning new
+ * strings) and probes the index once.
+ */
+bool hashSearch(const BookHashIndex& index, std::string_view lang, std::string_view type, size_t isbn) {
+    Book key;
+    if (!encodeBook(lang, type, isbn, key)) return false;
+    return index.contains(key);
+}
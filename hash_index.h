@@ -0,0 +1,109 @@
+/**
+ * hash_index.h
+ *
+ * Prebuilt hash index over a books vector for O(1) expected exact-match
+ * lookups.
+ *
+ * The index is an open-addressing table with linear probing. Slots are
+ * stored flat in one contiguous array and each slot holds the packed
+ * 16-byte Book itself (ISBN + type id + language id), so a probe touches a
+ * single cache line in the common case and never follows a pointer.
+ *
+ * Unlike the functions in search.h, the index does not require the books to
+ * be sorted.
+ */
+
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "book.h"
+
+/**
+ * BookHashIndex - Flat open-addressing set of books.
+ *
+ * Keyed on exactly the three fields Book::operator== compares. Duplicate
+ * books in the input are stored once.
+ */
+class BookHashIndex {
+public:
+    /**
+     * Build the index.
+     *
+     * The capacity is the next power of two that keeps the load factor at or
+     * below maxLoad, so probe sequences stay short.
+     *
+     * Time complexity: O(n) expected
+     * Space complexity: O(n / maxLoad) slots of 16 bytes
+     *
+     * @param books Books to index (any order)
+     * @param maxLoad Maximum fraction of occupied slots, in (0, 1)
+     */
+    explicit BookHashIndex(const std::vector<Book>& books, double maxLoad = 0.5);
+
+    /**
+     * Restore an index from a slot array previously returned by slots().
+     *
+     * Used to reload a saved index without rehashing (see snapshot.h). The
+     * slots must come from an index built with the same dictionary ids.
+     *
+     * @param slots Slot array; its size must be a power of two
+     * @param size Number of occupied slots
+     */
+    BookHashIndex(std::vector<Book> slots, size_t size);
+
+    /**
+     * Exact-match lookup on an encoded book.
+     *
+     * @param key Book to look for
+     * @return true if a book equal to key was indexed
+     */
+    bool contains(const Book& key) const;
+
+    /**
+     * @return Number of distinct books stored
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * @return Number of slots in the table
+     */
+    size_t capacity() const { return slots_.size(); }
+
+    /**
+     * @return The raw slot array, for saving the index (see snapshot.h)
+     */
+    const std::vector<Book>& slots() const { return slots_; }
+
+private:
+    /** Type id marking an empty slot; no record has it (see kTypeIdLimit). */
+    static constexpr uint16_t kEmptyType = kTypeIdLimit;
+
+    static uint64_t hash(const Book& b);
+
+    std::vector<Book> slots_;  // Flat slot array, capacity is a power of two
+    size_t mask_;              // capacity - 1
+    size_t size_;
+};
+
+/**
+ * Hash index search.
+ *
+ * Same contract as linearSearch/binarySearch, but answered from a prebuilt
+ * BookHashIndex instead of scanning or bisecting the books vector.
+ *
+ * Time complexity: O(1) expected
+ * Space complexity: O(1)
+ *
+ * @param index Prebuilt index over the books
+ * @param lang Target language to match
+ * @param type Target type to match
+ * @param isbn Target ISBN to match
+ * @return true if a book matching ALL three criteria is found, false otherwise
+ */
+bool hashSearch(const BookHashIndex& index, std::string_view lang, std::string_view type, size_t isbn);
+
+#endif // HASH_INDEX_H
@@ -0,0 +1,206 @@
+/**
+ * learned_index.cpp
+ *
+ * Implementation of the piecewise-linear learned ISBN index.
+ */
+
+#include "learned_index.h"
+#include "search_kernels.h"
+#include <algorithm>
+#include <limits>
+
+/** Error bound of the upper levels, which index segment keys. */
+static const size_t kLevelEpsilon = 8;
+
+/** A level this small is searched directly instead of getting a level above it. */
+static const size_t kTopLevelSize = 64;
+
+/**
+ * Slack added on each side of a search window, on top of epsilon, to absorb
+ * floating-point rounding in the prediction.
+ */
+static const size_t kRoundingSlack = 2;
+
+/**
+ * Fit error-bounded segments to points (xs[i], ys[i]), xs strictly increasing.
+ *
+ * Greedy shrinking cone: a segment starts at its first point, and every
+ * following point narrows the range of slopes that keep all points so far
+ * within +-epsilon. When the range becomes empty, the point starts the next
+ * segment. Slopes are kept non-negative, so predictions never decrease
+ * between two points of a segment.
+ */
+template <class Position>
+static std::vector<LearnedIndex::Segment> fitSegments(const std::vector<uint64_t>& xs, Position position,
+                                                     size_t epsilon) {
+    std::vector<LearnedIndex::Segment> segments;
+    double eps = static_cast<double>(epsilon);
+    size_t i = 0;
+    while (i < xs.size()) {
+        uint64_t x0 = xs[i];
+        double y0 = static_cast<double>(position(i));
+        double lo = 0;
+        double hi = std::numeric_limits<double>::infinity();
+        size_t j = i + 1;
+        for (; j < xs.size(); ++j) {
+            double dx = static_cast<double>(xs[j] - x0);
+            double y = static_cast<double>(position(j));
+            double l = std::max(lo, (y - eps - y0) / dx);
+            double h = std::min(hi, (y + eps - y0) / dx);
+            if (l > h) break;
+            lo = l;
+            hi = h;
+        }
+        segments.push_back({x0, j == i + 1 ? 0.0 : (lo + hi) / 2, y0});
+        i = j;
+    }
+    return segments;
+}
+
+/**
+ * Build the index.
+ *
+ * Algorithm:
+ * 1. Collect the distinct ISBNs and the position where each one starts
+ * 2. Fit the bottom level on (ISBN, position); drop the model if it needs
+ *    more than one segment per kMinKeysPerSegment ISBNs
+ * 3. While the top level is larger than kTopLevelSize, fit a level above it
+ *    on (segment key, segment index)
+ */
+LearnedIndex::LearnedIndex(const std::vector<Book>& books, size_t epsilon)
+    : books_(&books), epsilon_(std::max<size_t>(epsilon, 1)) {
+    // Step 1: distinct ISBNs in sorted order, with their first position
+    std::vector<uint64_t> keys;
+    std::vector<size_t> firstPos;
+    for (size_t i = 0; i < books.size(); ++i) {
+        if (i == 0 || books[i].getISBN() != books[i - 1].getISBN()) {
+            keys.push_back(books[i].getISBN());
+            firstPos.push_back(i);
+        }
+    }
+    if (keys.empty()) return;
+
+    // Step 2: bottom level
+    std::vector<Segment> bottom = fitSegments(keys, [&](size_t i) { return firstPos[i]; }, epsilon_);
+    if (bottom.size() > keys.size() / kMinKeysPerSegment) return;
+    levels_.push_back(std::move(bottom));
+
+    // Step 3: upper levels
+    while (levels_.back().size() > kTopLevelSize) {
+        const std::vector<Segment>& below = levels_.back();
+        keys.resize(below.size());
+        for (size_t i = 0; i < below.size(); ++i) keys[i] = below[i].key;
+        std::vector<Segment> level = fitSegments(keys, [](size_t i) { return i; }, kLevelEpsilon);
+        if (level.size() >= below.size()) break;  // Cannot shrink further; search this level directly
+        levels_.push_back(std::move(level));
+    }
+}
+
+/**
+ * Evaluate segment s of a level at isbn and return the window [first, last)
+ * of n entries that must contain the true position, for error bound epsilon.
+ *
+ * The prediction is capped at the start of the next segment: an ISBN past
+ * the last point of a segment but before the next one belongs exactly
+ * there, while the line itself keeps climbing across the gap.
+ */
+static inline std::pair<size_t, size_t> predictWindow(const std::vector<LearnedIndex::Segment>& level, size_t s,
+                                                      uint64_t isbn, size_t epsilon, size_t n) {
+    const LearnedIndex::Segment& g = level[s];
+    double limit = s + 1 < level.size() ? level[s + 1].base : static_cast<double>(n);
+    double predicted = std::min(limit, g.base + g.slope * static_cast<double>(isbn - g.key));
+    double reach = static_cast<double>(epsilon + kRoundingSlack);
+    double lo = std::max(0.0, predicted - reach);
+    double hi = std::min(static_cast<double>(n), predicted + reach + 1);
+    size_t first = std::min(static_cast<size_t>(lo), n);
+    size_t last = std::max(first, static_cast<size_t>(hi));
+    return {first, last};
+}
+
+/**
+ * Index of the last bottom segment whose key is <= isbn.
+ *
+ * Searches the top level directly, then at each level below searches only
+ * the window the segment above predicts. isbn is at least the first key of
+ * every level (checked by the caller), so the result is never before the
+ * first segment.
+ */
+size_t LearnedIndex::findSegment(uint64_t isbn) const {
+    auto keyAbove = [isbn](uint64_t key) { return key <= isbn; };
+    const std::vector<Segment>& top = levels_.back();
+    size_t s = std::partition_point(top.begin(), top.end(), [&](const Segment& g) { return keyAbove(g.key); })
+               - top.begin() - 1;
+    for (size_t level = levels_.size() - 1; level > 0; --level) {
+        const std::vector<Segment>& below = levels_[level - 1];
+        auto window = predictWindow(levels_[level], s, isbn, kLevelEpsilon, below.size());
+        auto it = std::partition_point(below.begin() + window.first, below.begin() + window.second,
+                                       [&](const Segment& b) { return keyAbove(b.key); });
+        s = std::max<size_t>(it - below.begin(), 1) - 1;
+    }
+    return s;
+}
+
+/**
+ * Windowed lower bound.
+ *
+ * Algorithm:
+ * 1. No model: branchless binary search over the whole vector
+ * 2. Below the first ISBN: 0
+ * 3. Find the bottom segment and search the +-epsilon window it predicts
+ * 4. The bound is exact for ISBNs in the catalog. An absent ISBN right
+ *    after a run of more than 2 * epsilon editions can be predicted short of
+ *    its position, so if the answer sits on a window edge, finish with a
+ *    search beyond that edge
+ */
+size_t LearnedIndex::lowerBound(size_t isbn) const {
+    const std::vector<Book>& books = *books_;
+    auto first = books.begin();
+    if (levels_.empty()) return branchlessLowerBound<IsbnOrder>(first, books.end(), isbn) - first;
+    if (isbn <= levels_[0][0].key) return 0;
+
+    auto window = predictWindow(levels_[0], findSegment(isbn), isbn, epsilon_, books.size());
+    // The window is a few contiguous cache lines: request them all at once
+    // so their misses overlap, instead of one per step of the search
+    const char* line = reinterpret_cast<const char*>(books.data() + window.first);
+    const char* end = reinterpret_cast<const char*>(books.data() + window.second);
+    for (; line < end; line += 64) __builtin_prefetch(line);
+    size_t pos = branchlessLowerBound<IsbnOrder>(first + window.first, first + window.second, isbn) - first;
+
+    if (pos == window.first && pos > 0 && books[pos - 1].getISBN() >= isbn) {
+        return branchlessLowerBound<IsbnOrder>(first, first + pos, isbn) - first;
+    }
+    if (pos == window.second && pos < books.size() && books[pos].getISBN() < isbn) {
+        return branchlessLowerBound<IsbnOrder>(first + pos, books.end(), isbn) - first;
+    }
+    return pos;
+}
+
+/**
+ * Exact-match lookup: one windowed descent, then a short scan over the
+ * ISBN's run.
+ */
+bool LearnedIndex::contains(const Book& key) const {
+    const std::vector<Book>& books = *books_;
+    for (size_t i = lowerBound(key.getISBN()); i < books.size() && books[i].getISBN() == key.getISBN(); ++i) {
+        if (books[i] == key) return true;
+    }
+    return false;
+}
+
+size_t LearnedIndex::memoryBytes() const {
+    size_t bytes = 0;
+    for (const auto& level : levels_) bytes += level.size() * sizeof(Segment);
+    return bytes;
+}
+
+/**
+ * Learned index search implementation.
+ *
+ * Translates language and type to their interned ids (without interning new
+ * strings) and runs one lookup on the index.
+ */
+bool learnedSearch(const LearnedIndex& index, std::string_view lang, std::string_view type, size_t isbn) {
+    Book key;
+    if (!encodeBook(lang, type, isbn, key)) return false;
+    return index.contains(key);
+}
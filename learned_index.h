@@ -0,0 +1,133 @@
+/**
+ * learned_index.h
+ *
+ * Piecewise-linear learned index (PGM-style) over the ISBNs of a sorted
+ * books vector.
+ *
+ * ISBNs are dense 13-digit numbers, so the position of an ISBN in the
+ * sorted vector is very nearly a linear function of the ISBN itself. The
+ * index stores that function as a short list of linear segments, each
+ * guaranteed to predict the position of every ISBN it covers to within
+ * +-epsilon records. A lookup evaluates the segment and then searches only
+ * the 2 * epsilon + 1 records around the prediction: a handful of cache
+ * lines instead of the ~25 scattered probes of a binary search over 20M
+ * records.
+ *
+ * The segment list is indexed the same way, recursively, with a smaller
+ * error bound, until the top level is small enough to search directly, so
+ * finding the right segment costs a few more short windowed searches.
+ *
+ * If the ISBNs are too irregular for the segments to pay off (fewer than
+ * kMinKeysPerSegment ISBNs per segment), the index keeps no model and
+ * falls back to a plain binary search.
+ */
+
+#ifndef LEARNED_INDEX_H
+#define LEARNED_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "book.h"
+
+/**
+ * LearnedIndex - Error-bounded linear segments mapping ISBN to position.
+ *
+ * The books vector passed to the constructor must be sorted by operator<,
+ * and must outlive the index without being modified.
+ */
+class LearnedIndex {
+public:
+    /** Default bound on the position error of the bottom segments. */
+    static constexpr size_t kDefaultEpsilon = 32;
+
+    /** Below this many ISBNs per bottom segment the model is dropped. */
+    static constexpr size_t kMinKeysPerSegment = 16;
+
+    /**
+     * Build the index.
+     *
+     * Time complexity: O(n)
+     * Space complexity: O(s) for s segments (24 bytes each); s is typically
+     *                   thousands of times smaller than n on real ISBNs
+     *
+     * @param books Vector of SORTED books
+     * @param epsilon Maximum position error of a bottom-level prediction
+     */
+    explicit LearnedIndex(const std::vector<Book>& books, size_t epsilon = kDefaultEpsilon);
+
+    /**
+     * Find the first book whose ISBN is >= isbn.
+     *
+     * @param isbn Target ISBN
+     * @return Index into the books vector, or books.size() if every ISBN is smaller
+     */
+    size_t lowerBound(size_t isbn) const;
+
+    /**
+     * Exact-match lookup on an encoded book.
+     *
+     * @param key Book to look for
+     * @return true if a book equal to key exists
+     */
+    bool contains(const Book& key) const;
+
+    /**
+     * @return false if the index fell back to binary search
+     */
+    bool usesModel() const { return !levels_.empty(); }
+
+    /**
+     * @return Number of bottom-level segments (0 without a model)
+     */
+    size_t segments() const { return levels_.empty() ? 0 : levels_[0].size(); }
+
+    /**
+     * @return Number of segment levels (0 without a model)
+     */
+    size_t levels() const { return levels_.size(); }
+
+    /**
+     * @return Bytes used by all segment levels
+     */
+    size_t memoryBytes() const;
+
+    /**
+     * Segment - Predicts position base + slope * (isbn - key) for the ISBNs
+     * from key up to the next segment's key.
+     */
+    struct Segment {
+        uint64_t key;
+        double slope;
+        double base;
+    };
+
+private:
+    size_t findSegment(uint64_t isbn) const;
+
+    const std::vector<Book>* books_;
+    size_t epsilon_;
+    std::vector<std::vector<Segment>> levels_;  // levels_[0] predicts book positions,
+                                                // levels_[i] predicts indices into levels_[i - 1]
+};
+
+/**
+ * Learned index search.
+ *
+ * Same contract as binarySearch, but the ISBN is located through a
+ * prebuilt LearnedIndex instead of a binary search over the books vector.
+ *
+ * Time complexity: O(log epsilon) per level, O(log n) on fallback
+ * Space complexity: O(1)
+ *
+ * @param index Prebuilt index over the SORTED books
+ * @param lang Target language to match
+ * @param type Target type to match
+ * @param isbn Target ISBN to match
+ * @return true if a book matching ALL three criteria is found, false otherwise
+ */
+bool learnedSearch(const LearnedIndex& index, std::string_view lang, std::string_view type, size_t isbn);
+
+#endif // LEARNED_INDEX_H
@@ -0,0 +1,211 @@
+/**
+ * loader.cpp
+ *
+ * Implementation of the mmap-based data file loader.
+ */
+
+#include "loader.h"
+#include "dictionary.h"
+#include "Timer.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ===== MappedFile =====
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+void MappedFile::close() {
+    if (data_ != nullptr) munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+    discarded_ = 0;
+}
+
+void MappedFile::discard(size_t upTo) {
+    static const size_t kPageBytes = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    upTo = std::min(upTo, size_) / kPageBytes * kPageBytes;
+    if (upTo <= discarded_) return;
+    madvise(const_cast<char*>(data_) + discarded_, upTo - discarded_, MADV_DONTNEED);
+    discarded_ = upTo;
+}
+
+/**
+ * Map a file read-only.
+ *
+ * An empty file is valid and maps to (nullptr, 0), since mmap rejects a
+ * zero length. The descriptor is closed right away; the mapping keeps the
+ * file contents alive.
+ */
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size > 0) {
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(p);
+        size_ = static_cast<size_t>(st.st_size);
+    }
+    ::close(fd);
+    return true;
+}
+
+// ===== Parsing =====
+
+/**
+ * Split a record at its first two commas and convert the ISBN in place.
+ * A trailing '\r' (CRLF line ending) is not part of the type.
+ */
+bool splitBookRecord(std::string_view line, size_t& isbn, std::string_view& lang, std::string_view& type) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    if (line.empty()) return false;
+
+    size_t p1 = line.find(',');
+    if (p1 == std::string_view::npos) return false;
+    size_t p2 = line.find(',', p1 + 1);
+    if (p2 == std::string_view::npos) return false;
+
+    const char* first = line.data();
+    const char* last = line.data() + p1;
+    auto result = std::from_chars(first, last, isbn);
+    if (result.ec != std::errc() || result.ptr != last) return false;  // Empty, non-numeric or out of range
+
+    lang = line.substr(p1 + 1, p2 - p1 - 1);
+    type = line.substr(p2 + 1);
+    return true;
+}
+
+bool parseBookRecord(std::string_view line, Book& out) {
+    size_t isbn;
+    std::string_view lang, type;
+    if (!splitBookRecord(line, isbn, lang, type)) return false;
+    uint32_t typeId = typeDictionary().intern(type);
+    if (typeId >= kTypeIdLimit) return false;  // Out of type ids
+    out = Book(isbn, languageDictionary().intern(lang), static_cast<uint16_t>(typeId));
+    return true;
+}
+
+RequestRecord encodeRequestRecord(std::string_view line, Book& out) {
+    size_t isbn;
+    std::string_view lang, type;
+    if (!splitBookRecord(line, isbn, lang, type)) return RequestRecord::Malformed;
+    return encodeBook(lang, type, isbn, out) ? RequestRecord::Encoded : RequestRecord::Unknown;
+}
+
+/**
+ * InternCache - Remembers the last few strings interned during one load.
+ *
+ * Data files use a handful of distinct languages and types, so nearly every
+ * record is answered here without taking the dictionary lock. The cached
+ * views point into the mapped file and are only valid during the load.
+ */
+class InternCache {
+public:
+    explicit InternCache(StringDictionary& dict) : dict_(dict) {}
+
+    uint32_t intern(std::string_view s) {
+        for (size_t i = 0; i < used_; ++i) {
+            if (names_[i] == s) return ids_[i];
+        }
+        uint32_t id = dict_.intern(s);
+        names_[next_] = s;
+        ids_[next_] = id;
+        next_ = (next_ + 1) % kSize;
+        if (used_ < kSize) ++used_;
+        return id;
+    }
+
+private:
+    static constexpr size_t kSize = 16;
+    StringDictionary& dict_;
+    std::string_view names_[kSize];
+    uint32_t ids_[kSize] = {};
+    size_t used_ = 0;
+    size_t next_ = 0;
+};
+
+/** Parsed bytes between two MappedFile::discard() calls. */
+static const size_t kDiscardBytes = 32 << 20;
+
+/**
+ * Load a data file.
+ *
+ * Algorithm:
+ * 1. Map the file and count its newlines to reserve the output once
+ * 2. Walk the buffer line by line with memchr, parsing each line in place
+ *    and dropping the parsed part of the mapping every kDiscardBytes, so
+ *    the peak footprint is the records plus one window of the file rather
+ *    than the records plus the whole file
+ * 3. Record the size, counts and elapsed time
+ */
+bool loadBookFile(const std::string& path, std::vector<Book>& out, LoadStats* stats) {
+    Timer timer;
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    const char* p = file.data();
+    const char* end = file.data() + file.size();
+
+    // Step 1: reserve for every line (plus a final line without a newline)
+    size_t lines = 0;
+    for (const char* q = p; q < end; ++lines) {
+        const char* nl = static_cast<const char*>(std::memchr(q, '\n', end - q));
+        q = nl == nullptr ? end : nl + 1;
+    }
+    out.reserve(out.size() + lines);
+
+    // Step 2: parse in place
+    InternCache languages(languageDictionary());
+    InternCache types(typeDictionary());
+    size_t records = 0;
+    size_t malformed = 0;
+    const char* discardAt = p + kDiscardBytes;
+    while (p < end) {
+        if (p >= discardAt) {
+            file.discard(p - file.data());
+            discardAt = p + kDiscardBytes;
+        }
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* lineEnd = nl == nullptr ? end : nl;
+        std::string_view line(p, lineEnd - p);
+        p = nl == nullptr ? end : nl + 1;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);  // A CRLF blank line is blank
+
+        size_t isbn;
+        std::string_view lang, type;
+        bool parsed = splitBookRecord(line, isbn, lang, type);
+        uint32_t typeId = parsed ? types.intern(type) : kTypeIdLimit;
+        if (typeId < kTypeIdLimit) {
+            out.emplace_back(isbn, languages.intern(lang), static_cast<uint16_t>(typeId));
+            ++records;
+        } else if (!line.empty()) {
+            ++malformed;
+        }
+    }
+
+    // Step 3: report
+    if (stats != nullptr) {
+        stats->bytes = file.size();
+        stats->records = records;
+        stats->malformed = malformed;
+        stats->microseconds = timer.ElapsedMicroseconds();
+    }
+    return true;
+}
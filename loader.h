@@ -0,0 +1,153 @@
+/**
+ * loader.h
+ *
+ * Zero-copy loader for the isbn,language,type data files (newbooks.dat and
+ * requests.dat).
+ *
+ * The file is mapped into memory with mmap and parsed in place: each record
+ * is split into string_view fields, the ISBN is converted with
+ * std::from_chars, and nothing throws. No per-line std::string is ever
+ * created.
+ */
+
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "book.h"
+
+/**
+ * MappedFile - Read-only memory mapping of a whole file.
+ *
+ * The mapping is released when the object is destroyed.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Map a file, replacing any previous mapping.
+     *
+     * @param path File to map
+     * @return false if the file cannot be opened or mapped
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @return Start of the mapped bytes (nullptr for an empty file)
+     */
+    const char* data() const { return data_; }
+
+    /**
+     * @return Number of mapped bytes
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * Drop the resident pages of the first upTo bytes.
+     *
+     * For a file read front to back once: the parsed prefix stops counting
+     * towards the process's memory. The bytes stay readable (a later access
+     * faults them back in from the file), so views into them remain valid.
+     *
+     * @param upTo Offset below which pages may be dropped (rounded down to a page)
+     */
+    void discard(size_t upTo);
+
+private:
+    void close();
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t discarded_ = 0;  // Bytes already dropped by discard()
+};
+
+/**
+ * LoadStats - What a load did and how fast it was.
+ */
+struct LoadStats {
+    size_t bytes = 0;        // File size
+    size_t records = 0;      // Records parsed successfully
+    size_t malformed = 0;    // Non-empty lines that were skipped
+    double microseconds = 0; // Wall time for map + parse
+
+    /**
+     * @return Load throughput in MB/s (10^6 bytes per second)
+     */
+    double megabytesPerSecond() const { return microseconds > 0 ? bytes / microseconds : 0.0; }
+};
+
+/**
+ * Split one record of the form isbn,language,type into its fields.
+ *
+ * Same rules as parseBookRecord(), but nothing is interned: the language
+ * and type come back as views into line, for callers that only look them
+ * up (e.g. to encode a search request).
+ *
+ * @param line One line without its terminating newline (a trailing '\r'
+ *        is ignored, so CRLF files parse like LF files)
+ * @param isbn Receives the ISBN on success
+ * @param lang Receives the language field on success
+ * @param type Receives the type field on success
+ * @return true if splitting succeeded, false if line is malformed or empty
+ */
+bool splitBookRecord(std::string_view line, size_t& isbn, std::string_view& lang, std::string_view& type);
+
+/**
+ * Parse one record of the form isbn,language,type.
+ *
+ * The ISBN field must consist of decimal digits only and fit in size_t.
+ * The type is everything after the second comma. A record whose type
+ * would get an id of kTypeIdLimit or more is rejected like a malformed one.
+ *
+ * @param line One line without its terminating newline
+ * @param out Receives the parsed book on success
+ * @return true if parsing succeeded, false if line is malformed, empty or
+ *         out of type ids
+ */
+bool parseBookRecord(std::string_view line, Book& out);
+
+/**
+ * RequestRecord - Outcome of encoding one request line.
+ */
+enum class RequestRecord {
+    Encoded,    // Parsed and encoded; can be searched
+    Unknown,    // Parsed, but its language or type was never interned (matches nothing)
+    Malformed   // Could not be parsed
+};
+
+/**
+ * Parse and encode one request line without interning anything.
+ *
+ * For request streams from outside (streaming mode, server mode): the
+ * language and type are only looked up, so never-seen strings cannot grow
+ * the dictionaries.
+ *
+ * @param line One line without its terminating newline
+ * @param out Receives the encoded request if the result is Encoded
+ * @return Whether the line was encoded, unknown or malformed
+ */
+RequestRecord encodeRequestRecord(std::string_view line, Book& out);
+
+/**
+ * Load every record of a data file.
+ *
+ * Malformed and empty lines are skipped, and so are records whose type is
+ * out of ids (counted as malformed). Records are appended to out in
+ * file order; capacity is reserved up front from the file's line count.
+ *
+ * @param path File to load
+ * @param out Receives the parsed books (appended)
+ * @param stats If not null, receives size, counts and timing of the load
+ * @return false if the file cannot be opened
+ */
+bool loadBookFile(const std::string& path, std::vector<Book>& out, LoadStats* stats = nullptr);
+
+#endif // LOADER_H
@@ -0,0 +1,47 @@
+/**
+ * parallel.h
+ *
+ * Minimal fork-join helper for splitting a range of work across threads.
+ *
+ * The range [0, n) is cut into one contiguous chunk per thread. Each worker
+ * gets its thread index so it can write its result into its own slot; the
+ * caller reduces those slots after the join, so the hot loop never touches
+ * shared state.
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * Run fn(thread, begin, end) over [0, n) split into contiguous chunks.
+ *
+ * The calling thread runs the first chunk itself, so threads == 1 never
+ * spawns anything. Chunks are as equal as possible; if n < threads, only n
+ * workers get work.
+ *
+ * @param n Number of work items
+ * @param threads Number of workers (0 is treated as 1)
+ * @param fn Callable taking (unsigned thread, size_t begin, size_t end)
+ */
+template <class Fn>
+void parallelFor(size_t n, unsigned threads, Fn fn) {
+    if (threads == 0) threads = 1;
+    if (n < threads) threads = n == 0 ? 1 : static_cast<unsigned>(n);
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t) {
+        size_t begin = n * t / threads;
+        size_t end = n * (t + 1) / threads;
+        workers.emplace_back([&fn, t, begin, end] { fn(t, begin, end); });
+    }
+    fn(0u, size_t(0), n / threads);
+    for (auto& w : workers) w.join();
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,237 @@
+/**
+ * pipeline.cpp
+ *
+ * Implementation of the streaming reader -> parser -> workers -> writer
+ * request search.
+ */
+
+#include "pipeline.h"
+#include "loader.h"
+#include "spsc_queue.h"
+#include "Timer.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/** Slots per queue; with 1 MiB chunks this bounds memory to a few MiB per stage. */
+static const size_t kQueueSlots = 4;
+
+/**
+ * Result of one request line, filled in by the parser and the workers.
+ */
+enum class LineStatus : uint8_t {
+    Search,     // Parsed; result is the line's entry in StreamChunk::found
+    NotFound,   // Parsed, but its language or type is unknown to the catalog
+    Malformed   // Could not be parsed
+};
+
+/**
+ * StreamChunk - A run of whole lines, passed from stage to stage.
+ */
+struct StreamChunk {
+    std::string text;                                // Raw bytes, cut at a line boundary
+    std::vector<std::pair<size_t, size_t>> lines;    // (offset, length) of each non-empty line
+    std::vector<LineStatus> status;                  // One per line
+    std::vector<Book> keys;                          // Encoded requests of the Search lines, in order
+    std::vector<bool> found;                         // One per key
+};
+
+using ChunkQueue = SpscQueue<std::unique_ptr<StreamChunk>>;
+
+/**
+ * Reader stage: read the file in chunks and cut each at its last newline,
+ * carrying the partial line over to the next chunk.
+ */
+static void readStage(int fd, size_t chunkBytes, ChunkQueue& out, size_t& bytes, std::atomic<bool>& failed) {
+    std::string carry;
+    while (true) {
+        auto chunk = std::make_unique<StreamChunk>();
+        chunk->text = std::move(carry);
+        carry.clear();
+        size_t old = chunk->text.size();
+        chunk->text.resize(old + chunkBytes);
+        ssize_t n;
+        do {
+            n = ::read(fd, &chunk->text[old], chunkBytes);
+        } while (n < 0 && errno == EINTR);
+        if (n < 0) {
+            failed = true;
+            break;
+        }
+        chunk->text.resize(old + static_cast<size_t>(n));
+        bytes += static_cast<size_t>(n);
+
+        if (n == 0) {
+            // End of file: whatever is left is the last line (no final newline)
+            if (!chunk->text.empty()) out.push(std::move(chunk));
+            break;
+        }
+        size_t lastNewline = chunk->text.rfind('\n');
+        if (lastNewline == std::string::npos) {
+            carry = std::move(chunk->text);  // A line longer than the chunk; keep reading
+            continue;
+        }
+        carry.assign(chunk->text, lastNewline + 1, std::string::npos);
+        chunk->text.resize(lastNewline + 1);
+        out.push(std::move(chunk));
+    }
+    out.close();
+}
+
+/**
+ * Parser stage: split chunks into lines, encode them and deal the chunks
+ * round-robin to the workers.
+ *
+ * Requests are encoded with encodeRequestRecord(), which never interns, so
+ * a stream of never-seen strings cannot grow the dictionaries.
+ */
+static void parseStage(ChunkQueue& in, std::vector<std::unique_ptr<ChunkQueue>>& workers,
+                       size_t& requests, size_t& malformed) {
+    std::unique_ptr<StreamChunk> chunk;
+    size_t next = 0;
+    while (in.pop(chunk)) {
+        std::string_view text(chunk->text);
+        size_t p = 0;
+        while (p < text.size()) {
+            size_t nl = text.find('\n', p);
+            size_t end = nl == std::string_view::npos ? text.size() : nl;
+            std::string_view line = text.substr(p, end - p);
+            size_t offset = p;
+            p = end + 1;
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);  // Echo CRLF lines without the '\r'
+            if (line.empty()) continue;
+
+            chunk->lines.emplace_back(offset, line.size());
+            Book key;
+            switch (encodeRequestRecord(line, key)) {
+            case RequestRecord::Malformed:
+                chunk->status.push_back(LineStatus::Malformed);
+                ++malformed;
+                break;
+            case RequestRecord::Unknown:
+                chunk->status.push_back(LineStatus::NotFound);
+                ++requests;
+                break;
+            case RequestRecord::Encoded:
+                chunk->status.push_back(LineStatus::Search);
+                chunk->keys.push_back(key);
+                ++requests;
+                break;
+            }
+        }
+        workers[next]->push(std::move(chunk));
+        next = (next + 1) % workers.size();
+    }
+    for (auto& q : workers) q->close();
+}
+
+/**
+ * Worker stage: answer every request of a chunk in one batch.
+ */
+static void searchStage(const Searcher& searcher, ChunkQueue& in, ChunkQueue& out) {
+    std::unique_ptr<StreamChunk> chunk;
+    while (in.pop(chunk)) {
+        chunk->found = searcher.findBatch(chunk->keys);
+        out.push(std::move(chunk));
+    }
+    out.close();
+}
+
+/**
+ * Run the pipeline.
+ *
+ * Algorithm:
+ * 1. Open both files (failures are reported before any thread starts)
+ * 2. Start the reader, the parser and the workers
+ * 3. Write results on the calling thread, collecting chunks from the
+ *    workers in the same round-robin order the parser dealt them
+ * 4. Join and report
+ *
+ * The writer keeps draining after a write error, so the other stages never
+ * block on a full queue.
+ */
+bool streamSearch(const Searcher& searcher, const std::string& requestsPath, const std::string& outPath,
+                  unsigned workers, StreamStats* stats, size_t chunkBytes) {
+    Timer timer;
+    if (workers == 0) workers = 1;
+    if (chunkBytes == 0) chunkBytes = kStreamChunkBytes;
+
+    // Step 1: open files
+    int fd = ::open(requestsPath.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    FILE* out = std::fopen(outPath.c_str(), "w");
+    if (out == nullptr) {
+        ::close(fd);
+        return false;
+    }
+    std::vector<char> outBuffer(1 << 20);
+    std::setvbuf(out, outBuffer.data(), _IOFBF, outBuffer.size());
+
+    // Step 2: start the stages
+    ChunkQueue raw(kQueueSlots);
+    std::vector<std::unique_ptr<ChunkQueue>> toWorkers, fromWorkers;
+    for (unsigned w = 0; w < workers; ++w) {
+        toWorkers.push_back(std::make_unique<ChunkQueue>(kQueueSlots));
+        fromWorkers.push_back(std::make_unique<ChunkQueue>(kQueueSlots));
+    }
+    std::atomic<bool> readFailed{false};
+    size_t bytes = 0, requests = 0, malformed = 0;
+
+    std::vector<std::thread> threads;
+    threads.emplace_back(readStage, fd, chunkBytes, std::ref(raw), std::ref(bytes), std::ref(readFailed));
+    threads.emplace_back(parseStage, std::ref(raw), std::ref(toWorkers), std::ref(requests), std::ref(malformed));
+    for (unsigned w = 0; w < workers; ++w) {
+        threads.emplace_back(searchStage, std::cref(searcher), std::ref(*toWorkers[w]), std::ref(*fromWorkers[w]));
+    }
+
+    // Step 3: write results in input order
+    static const char kFound[] = "\tfound\n";
+    static const char kNotFound[] = "\tnot found\n";
+    static const char kMalformed[] = "\tmalformed\n";
+    size_t found = 0;
+    bool writeFailed = false;
+    std::unique_ptr<StreamChunk> chunk;
+    for (unsigned w = 0; fromWorkers[w]->pop(chunk); w = (w + 1) % workers) {
+        size_t k = 0;
+        for (size_t i = 0; i < chunk->lines.size(); ++i) {
+            const char* suffix = kNotFound;
+            size_t suffixLen = sizeof(kNotFound) - 1;
+            if (chunk->status[i] == LineStatus::Malformed) {
+                suffix = kMalformed;
+                suffixLen = sizeof(kMalformed) - 1;
+            } else if (chunk->status[i] == LineStatus::Search && chunk->found[k++]) {
+                suffix = kFound;
+                suffixLen = sizeof(kFound) - 1;
+                ++found;
+            }
+            if (writeFailed) continue;
+            const auto& line = chunk->lines[i];
+            if (std::fwrite(chunk->text.data() + line.first, 1, line.second, out) != line.second
+                || std::fwrite(suffix, 1, suffixLen, out) != suffixLen) {
+                writeFailed = true;
+            }
+        }
+    }
+
+    // Step 4: join and report
+    for (auto& t : threads) t.join();
+    ::close(fd);
+    if (std::fclose(out) != 0) writeFailed = true;
+
+    if (stats != nullptr) {
+        stats->bytes = bytes;
+        stats->requests = requests;
+        stats->found = found;
+        stats->malformed = malformed;
+        stats->microseconds = timer.ElapsedMicroseconds();
+    }
+    return !readFailed && !writeFailed;
+}
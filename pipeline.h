@@ -0,0 +1,65 @@
+/**
+ * pipeline.h
+ *
+ * Streaming request search for request files too large to load.
+ *
+ * The requests file is never held in memory as a whole. It flows through
+ * four stages connected by bounded single-producer single-consumer queues
+ * (see spsc_queue.h):
+ *
+ *   reader -> parser -> search workers (N) -> writer
+ *
+ * - reader:  read()s the file in fixed-size chunks cut at line boundaries
+ * - parser:  splits each chunk into lines and encodes them as Books, without
+ *            interning (an unknown language or type cannot match anything)
+ * - workers: answer a whole chunk with Searcher::findBatch()
+ * - writer:  writes every request line followed by its result
+ *
+ * The parser deals chunks to the workers round-robin, and the writer
+ * collects them from the workers in the same round-robin order, so the
+ * output is in input order without any reordering buffer. Memory use is
+ * bounded by the chunk size times the number of queue slots, whatever the
+ * size of the input.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <cstddef>
+#include <string>
+#include "searcher.h"
+
+/** Default number of bytes the reader reads per chunk. */
+constexpr size_t kStreamChunkBytes = size_t(1) << 20;
+
+/**
+ * StreamStats - What a streaming search did and how fast it was.
+ */
+struct StreamStats {
+    size_t bytes = 0;         // Bytes read from the requests file
+    size_t requests = 0;      // Well-formed request lines
+    size_t found = 0;         // Requests that matched a book
+    size_t malformed = 0;     // Non-empty lines that could not be parsed
+    double microseconds = 0;  // Wall time from first read to last write
+};
+
+/**
+ * Search every request of a file, streaming, and write one result line per
+ * request.
+ *
+ * Output lines are the request line, a tab, and "found", "not found" or
+ * "malformed", in input order. Empty lines are skipped.
+ *
+ * @param searcher Searcher over the SORTED catalog (shared by all workers)
+ * @param requestsPath Requests file (isbn,language,type per line)
+ * @param outPath File receiving the per-request results
+ * @param workers Number of search worker threads (0 is treated as 1)
+ * @param stats If not null, receives counts and timing
+ * @param chunkBytes Bytes per read; a chunk grows past this only to finish
+ *        a line longer than it
+ * @return false if either file cannot be opened, or reading or writing fails
+ */
+bool streamSearch(const Searcher& searcher, const std::string& requestsPath, const std::string& outPath,
+                  unsigned workers, StreamStats* stats = nullptr, size_t chunkBytes = kStreamChunkBytes);
+
+#endif // PIPELINE_H
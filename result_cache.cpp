@@ -0,0 +1,126 @@
+/**
+ * result_cache.cpp
+ *
+ * Implementation of the set-associative CLOCK result cache.
+ */
+
+#include "result_cache.h"
+#include <thread>
+
+static_assert(ResultCache::kWays <= 8, "way bitmasks are 8 bits wide");
+
+/**
+ * Mix the three fields of a key into a set index. Independent of the Bloom
+ * filter's hash, so keys that collide there spread out here.
+ */
+static inline uint64_t hashKey(const Book& key) {
+    uint64_t h = key.getISBN() * 0x9E3779B97F4A7C15ULL;
+    h ^= ((static_cast<uint64_t>(key.getLanguageId()) << 16) | key.getTypeId()) * 0xC2B2AE3D27D4EB4FULL;
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    return h ^ (h >> 32);
+}
+
+ResultCache::ResultCache(const CacheSettings& settings) {
+    size_t sets = 1;
+    while (sets * kWays < settings.capacity) sets <<= 1;
+    sets_.reset(new Set[sets]);
+    mask_ = sets - 1;
+}
+
+/**
+ * Lock the key's set, clearing it first if it predates the last
+ * invalidate().
+ */
+ResultCache::Set& ResultCache::acquire(const Book& key) {
+    Set& set = sets_[hashKey(key) & mask_];
+    for (unsigned spins = 0; set.lock.test_and_set(std::memory_order_acquire); ++spins) {
+        if (spins >= 64) std::this_thread::yield();
+    }
+    uint64_t generation = generation_.load(std::memory_order_acquire);
+    if (set.generation != generation) {
+        set.generation = generation;
+        set.valid = 0;
+        set.referenced = 0;
+    }
+    return set;
+}
+
+bool ResultCache::lookup(const Book& key, bool& found) {
+    Set& set = acquire(key);
+    for (unsigned w = 0; w < kWays; ++w) {
+        uint8_t bit = static_cast<uint8_t>(1u << w);
+        if ((set.valid & bit) && set.keys[w] == key) {
+            set.referenced |= bit;
+            found = (set.found & bit) != 0;
+            ++set.hits;
+            release(set);
+            return true;
+        }
+    }
+    ++set.misses;
+    release(set);
+    return false;
+}
+
+/**
+ * Insert into the key's set.
+ *
+ * Algorithm:
+ * 1. If the key is already there (another thread raced us), update it
+ * 2. Otherwise take a free way if there is one
+ * 3. Otherwise sweep the hand: clear referenced bits until an
+ *    unreferenced way comes up, and evict it
+ */
+void ResultCache::insert(const Book& key, bool found) {
+    Set& set = acquire(key);
+    unsigned way = kWays;
+    for (unsigned w = 0; w < kWays; ++w) {
+        if ((set.valid & (1u << w)) && set.keys[w] == key) {
+            way = w;
+            break;
+        }
+    }
+    if (way == kWays) {
+        for (unsigned w = 0; w < kWays && way == kWays; ++w) {
+            if (!(set.valid & (1u << w))) way = w;
+        }
+        if (way == kWays) {
+            while (set.referenced & (1u << set.hand)) {
+                set.referenced = static_cast<uint8_t>(set.referenced & ~(1u << set.hand));
+                set.hand = static_cast<uint8_t>((set.hand + 1) % kWays);
+            }
+            way = set.hand;
+            set.hand = static_cast<uint8_t>((set.hand + 1) % kWays);
+            ++set.evictions;
+        }
+        uint8_t bit = static_cast<uint8_t>(1u << way);
+        set.keys[way] = key;
+        set.valid |= bit;
+        set.referenced = static_cast<uint8_t>(set.referenced & ~bit);
+        ++set.insertions;
+    }
+    uint8_t bit = static_cast<uint8_t>(1u << way);
+    set.found = static_cast<uint8_t>(found ? set.found | bit : set.found & ~bit);
+    release(set);
+}
+
+void ResultCache::invalidate() {
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    ++invalidations_;
+}
+
+CacheStats ResultCache::stats() const {
+    CacheStats s;
+    for (size_t i = 0; i <= mask_; ++i) {
+        Set& set = sets_[i];
+        while (set.lock.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+        s.hits += set.hits;
+        s.misses += set.misses;
+        s.insertions += set.insertions;
+        s.evictions += set.evictions;
+        release(set);
+    }
+    s.invalidations = invalidations_;
+    return s;
+}
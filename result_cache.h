@@ -0,0 +1,125 @@
+/**
+ * result_cache.h
+ *
+ * Bounded cache of lookup results for skewed request streams.
+ *
+ * When a small set of (ISBN, type, language) triples makes up most of the
+ * traffic, remembering their answers skips the search for all but the
+ * first request of each. The cache is set-associative: a key hashes to one
+ * set of kWays entries, stored inline (keys, valid/referenced/found bits
+ * and counters in one flat array of 64-byte-aligned sets), so a lookup
+ * touches a few adjacent cache lines and never allocates.
+ *
+ * Replacement is CLOCK within each set: a hit sets the entry's referenced
+ * bit, and an insert into a full set sweeps the set's hand past referenced
+ * entries (clearing their bits) and evicts the first unreferenced one. A
+ * new entry starts unreferenced, so one-off requests are evicted ahead of
+ * anything hit since the hand last went by, and an entry that keeps being
+ * hit is never evicted.
+ *
+ * Every set has its own spinlock, so threads only contend when they hit
+ * the same set. invalidate() drops every entry in O(1): it bumps a
+ * generation number, and each set clears itself the next time it is
+ * touched under a newer generation.
+ */
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "book.h"
+
+/**
+ * CacheSettings - How to size a ResultCache.
+ */
+struct CacheSettings {
+    size_t capacity = 1 << 16;  // Entries to hold; rounded up to a power-of-two number of sets
+};
+
+/**
+ * CacheStats - What a ResultCache did.
+ */
+struct CacheStats {
+    size_t hits = 0;           // Lookups answered from the cache
+    size_t misses = 0;         // Lookups that had to search
+    size_t insertions = 0;     // Results stored
+    size_t evictions = 0;      // Stored results dropped to make room
+    size_t invalidations = 0;  // invalidate() calls
+};
+
+/**
+ * ResultCache - Set-associative CLOCK cache from Book to found/not found.
+ */
+class ResultCache {
+public:
+    /** Entries per set. */
+    static constexpr unsigned kWays = 8;
+
+    /**
+     * @param settings Capacity of the cache
+     */
+    explicit ResultCache(const CacheSettings& settings = CacheSettings());
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    /**
+     * Look up a cached result.
+     *
+     * @param key Encoded request
+     * @param found Receives the cached result on a hit
+     * @return true on a hit
+     */
+    bool lookup(const Book& key, bool& found);
+
+    /**
+     * Store a result, evicting by CLOCK if the key's set is full.
+     *
+     * @param key Encoded request
+     * @param found Its result
+     */
+    void insert(const Book& key, bool found);
+
+    /**
+     * Drop every entry (e.g. after the catalog changed wholesale).
+     */
+    void invalidate();
+
+    /**
+     * @return Number of entries the cache can hold
+     */
+    size_t capacity() const { return (mask_ + 1) * kWays; }
+
+    /**
+     * @return Counters summed over all sets
+     */
+    CacheStats stats() const;
+
+private:
+    struct alignas(64) Set {
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;
+        uint8_t hand = 0;        // Next way the CLOCK sweep looks at
+        uint8_t valid = 0;       // Bit w: way w holds an entry
+        uint8_t referenced = 0;  // Bit w: way w was hit since the hand last passed
+        uint8_t found = 0;       // Bit w: cached result of way w
+        uint64_t generation = 0;
+        uint64_t hits = 0;        // Counters, updated under the set's lock
+        uint64_t misses = 0;
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+        Book keys[kWays];
+    };
+
+    Set& acquire(const Book& key);
+    static void release(Set& set) { set.lock.clear(std::memory_order_release); }
+
+    std::unique_ptr<Set[]> sets_;
+    size_t mask_;
+    std::atomic<uint64_t> generation_{0};
+    std::atomic<size_t> invalidations_{0};
+};
+
+#endif // RESULT_CACHE_H
@@ -0,0 +1,192 @@
+/**
+ * results.cpp
+ *
+ * Implementation of per-request result sets.
+ */
+
+#include "results.h"
+#include "loader.h"
+#include "search.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char kMagic[8] = {'B', 'O', 'O', 'K', 'R', 'S', 'L', 'T'};
+
+static_assert(sizeof(ResultFileHeader) % 16 == 0, "records after the header must stay 16-byte aligned");
+static_assert(sizeof(ResultRecord) == 16, "result records are two 64-bit words");
+
+/** Longest text line: two 20-digit numbers, "\tnot found" and separators. */
+static const size_t kMaxTextLine = 64;
+
+bool parseResultFormat(const std::string& name, ResultFormat& out) {
+    if (name == "text") out = ResultFormat::Text;
+    else if (name == "binary") out = ResultFormat::Binary;
+    else return false;
+    return true;
+}
+
+/**
+ * Write all of [data, data + size) to fd, retrying short and interrupted writes.
+ */
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+ResultWriter::ResultWriter(size_t bufferBytes)
+    : buffer_(std::max(bufferBytes, std::max(kMaxTextLine, sizeof(ResultRecord)))) {}
+
+ResultWriter::~ResultWriter() {
+    if (fd_ >= 0) close();
+}
+
+/**
+ * Open the output file. A binary result set starts with a placeholder
+ * header, completed by close() once the record count is known.
+ */
+bool ResultWriter::open(const std::string& path, ResultFormat format) {
+    if (fd_ >= 0) close();
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) return false;
+    format_ = format;
+    used_ = 0;
+    records_ = 0;
+    failed_ = false;
+    if (format_ == ResultFormat::Binary) {
+        ResultFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(buffer_.data(), &header, sizeof(header));
+        used_ = sizeof(header);
+    }
+    return true;
+}
+
+void ResultWriter::flush() {
+    if (!failed_ && !writeAll(fd_, buffer_.data(), used_)) failed_ = true;
+    used_ = 0;
+}
+
+/**
+ * Format one record into the buffer, flushing it first if the record might
+ * not fit.
+ */
+void ResultWriter::add(uint64_t request, uint64_t position) {
+    size_t need = format_ == ResultFormat::Binary ? sizeof(ResultRecord) : kMaxTextLine;
+    if (buffer_.size() - used_ < need) flush();
+    char* p = buffer_.data() + used_;
+    if (format_ == ResultFormat::Binary) {
+        ResultRecord record{request, position};
+        std::memcpy(p, &record, sizeof(record));
+        p += sizeof(record);
+    } else {
+        static const char kFound[] = "\tfound\t";
+        static const char kNotFound[] = "\tnot found\n";
+        p = std::to_chars(p, p + 20, request).ptr;
+        if (position == kNoPosition) {
+            std::memcpy(p, kNotFound, sizeof(kNotFound) - 1);
+            p += sizeof(kNotFound) - 1;
+        } else {
+            std::memcpy(p, kFound, sizeof(kFound) - 1);
+            p += sizeof(kFound) - 1;
+            p = std::to_chars(p, p + 20, position).ptr;
+            *p++ = '\n';
+        }
+    }
+    used_ = static_cast<size_t>(p - buffer_.data());
+    ++records_;
+}
+
+/**
+ * Flush, then (binary) rewrite the header in place with the final count.
+ */
+bool ResultWriter::close() {
+    if (fd_ < 0) return !failed_;
+    flush();
+    if (format_ == ResultFormat::Binary && !failed_) {
+        ResultFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kResultVersion;
+        header.recordBytes = sizeof(ResultRecord);
+        header.recordCount = records_;
+        if (::pwrite(fd_, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) failed_ = true;
+    }
+    if (::close(fd_) != 0) failed_ = true;
+    fd_ = -1;
+    return !failed_;
+}
+
+/**
+ * Write a result set.
+ *
+ * Algorithm:
+ * 1. Open the writer
+ * 2. For every request in order: locate it in the catalog if its flag is
+ *    set (first equal record), and add its record
+ * 3. Close, reporting any write error
+ */
+template <class Locate>
+static bool writeResults(const std::string& path, ResultFormat format, const std::vector<Book>& requests,
+                         const std::vector<uint8_t>& found, Locate locate) {
+    ResultWriter writer;
+    if (!writer.open(path, format)) return false;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        uint64_t position = kNoPosition;
+        if (i < found.size() && found[i]) position = locate(requests[i]);
+        writer.add(i, position);
+    }
+    return writer.close();
+}
+
+bool writeResultSet(const std::string& path, ResultFormat format, const std::vector<Book>& books,
+                    const std::vector<Book>& requests, const std::vector<uint8_t>& found) {
+    return writeResults(path, format, requests, found, [&books](const Book& request) {
+        BookRange match = equalRange(books, request);
+        return match.empty() ? kNoPosition : static_cast<uint64_t>(match.first - books.begin());
+    });
+}
+
+bool writeResultSet(const std::string& path, ResultFormat format, const CompressedCatalog& catalog,
+                    const std::vector<Book>& requests, const std::vector<uint8_t>& found) {
+    return writeResults(path, format, requests, found, [&catalog](const Book& request) {
+        size_t position = catalog.find(request);
+        return position == CompressedCatalog::npos ? kNoPosition : static_cast<uint64_t>(position);
+    });
+}
+
+static bool fail(std::string* error, const char* message) {
+    if (error != nullptr) *error = message;
+    return false;
+}
+
+bool readResultFile(const std::string& path, std::vector<ResultRecord>& out, std::string* error) {
+    MappedFile file;
+    if (!file.open(path)) return fail(error, "cannot open file");
+    if (file.size() < sizeof(ResultFileHeader)) return fail(error, "file too small for a result header");
+
+    ResultFileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) return fail(error, "not a result file");
+    if (header.version != kResultVersion || header.recordBytes != sizeof(ResultRecord)) {
+        return fail(error, "unsupported result file version");
+    }
+    size_t payload = file.size() - sizeof(ResultFileHeader);
+    if (payload % sizeof(ResultRecord) != 0 || header.recordCount != payload / sizeof(ResultRecord)) {
+        return fail(error, "result records do not match the file size");
+    }
+    out.resize(header.recordCount);
+    if (!out.empty()) std::memcpy(out.data(), file.data() + sizeof(ResultFileHeader), payload);
+    return true;
+}
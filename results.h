@@ -0,0 +1,192 @@
+/**
+ * results.h
+ *
+ * Per-request result sets: which requests matched, and where.
+ *
+ * By default SearchNewBooks writes only the number of requests found. A
+ * result set instead records, for every request in input order, its index
+ * among the parsed requests, whether it was found and the position of the
+ * matching record in the sorted catalog (the order a snapshot stores), so
+ * the matches can be used downstream without joining the two files again.
+ *
+ * The request index counts only the lines the loader parsed: blank and
+ * malformed lines (see LoadStats) are skipped without taking an index, so
+ * it equals the line number only in a file without such lines.
+ *
+ * Two formats:
+ *
+ * - Text, one line per request:
+ *       <request>\tfound\t<position>
+ *       <request>\tnot found
+ *
+ * - Binary (native byte order):
+ *       ResultFileHeader
+ *       ResultRecord records[recordCount]
+ *   A miss has position kNoPosition. Records are fixed-size, so the file
+ *   can be mapped and indexed directly by request number.
+ *
+ * Both are written through ResultWriter, which fills a large buffer and
+ * hands it to the kernel in whole blocks.
+ */
+
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "book.h"
+#include "compressed_catalog.h"
+
+/** Current binary result format version; bumped whenever the layout changes. */
+constexpr uint32_t kResultVersion = 1;
+
+/** Position recorded for a request that matched nothing. */
+constexpr uint64_t kNoPosition = ~uint64_t(0);
+
+/** Default ResultWriter buffer size. */
+constexpr size_t kResultBufferBytes = size_t(1) << 20;
+
+/**
+ * ResultFormat - How a result set is written.
+ */
+enum class ResultFormat {
+    Text,   // One tab-separated line per request
+    Binary  // ResultFileHeader followed by one ResultRecord per request
+};
+
+/**
+ * Parse a result format name ("text" or "binary").
+ *
+ * @param name The user's input
+ * @param out Receives the format on success
+ * @return false if name is not a known format
+ */
+bool parseResultFormat(const std::string& name, ResultFormat& out);
+
+/**
+ * ResultFileHeader - Fixed-size header at offset 0 of a binary result file.
+ */
+struct ResultFileHeader {
+    char magic[8];         // "BOOKRSLT"
+    uint32_t version;      // kResultVersion
+    uint32_t recordBytes;  // sizeof(ResultRecord)
+    uint64_t recordCount;  // Number of records that follow
+    uint64_t reserved;     // Zero; pads the header to a multiple of 16 bytes
+};
+
+/**
+ * ResultRecord - The result of one request.
+ */
+struct ResultRecord {
+    uint64_t request;   // Index of the request among the parsed requests (0-based; skipped lines take no index)
+    uint64_t position;  // Index of the matching record in the sorted catalog, or kNoPosition
+
+    bool found() const { return position != kNoPosition; }
+};
+
+/**
+ * ResultWriter - Buffered writer of a result set.
+ *
+ * Records are formatted straight into one large buffer, which is written
+ * out only when full (and on close), so a result set of millions of
+ * requests costs a few hundred write() calls.
+ */
+class ResultWriter {
+public:
+    /**
+     * @param bufferBytes Size of the output buffer (at least one text line)
+     */
+    explicit ResultWriter(size_t bufferBytes = kResultBufferBytes);
+
+    /**
+     * Closes the file if still open, ignoring errors; call close() to see them.
+     */
+    ~ResultWriter();
+
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    /**
+     * Create (or truncate) path and start a result set in format.
+     *
+     * @param path Output file
+     * @param format Text or binary
+     * @return false if the file cannot be created
+     */
+    bool open(const std::string& path, ResultFormat format);
+
+    /**
+     * Append the result of one request.
+     *
+     * @param request Index of the request among the parsed requests
+     * @param position Index of the matching catalog record, or kNoPosition for a miss
+     */
+    void add(uint64_t request, uint64_t position);
+
+    /**
+     * Flush the buffer, complete the header (binary) and close the file.
+     *
+     * @return false if any write since open() failed
+     */
+    bool close();
+
+    /**
+     * @return Number of records added since open()
+     */
+    uint64_t records() const { return records_; }
+
+private:
+    void flush();
+
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+    int fd_ = -1;
+    ResultFormat format_ = ResultFormat::Text;
+    uint64_t records_ = 0;
+    bool failed_ = false;
+};
+
+/**
+ * Write the result set of a searched batch of requests.
+ *
+ * The hit flags come from the timed search (Searcher::countFoundParallel);
+ * only the matched requests are located again here, with one descent on
+ * the sorted catalog each, outside the timed phase.
+ *
+ * @param path Output file
+ * @param format Text or binary
+ * @param books Vector of SORTED books that was searched
+ * @param requests Encoded requests, in input order
+ * @param found One flag per request, 1 if it was found
+ * @return false if the file cannot be written
+ */
+bool writeResultSet(const std::string& path, ResultFormat format, const std::vector<Book>& books,
+                    const std::vector<Book>& requests, const std::vector<uint8_t>& found);
+
+/**
+ * Write the result set of a batch searched on a compressed catalog, which
+ * locates each matched request by decoding one block.
+ *
+ * @param path Output file
+ * @param format Text or binary
+ * @param catalog Compressed catalog that was searched
+ * @param requests Encoded requests, in input order
+ * @param found One flag per request, 1 if it was found
+ * @return false if the file cannot be written
+ */
+bool writeResultSet(const std::string& path, ResultFormat format, const CompressedCatalog& catalog,
+                    const std::vector<Book>& requests, const std::vector<uint8_t>& found);
+
+/**
+ * Read a binary result file back.
+ *
+ * @param path File written with ResultFormat::Binary
+ * @param out Receives the records, in request order
+ * @param error If not null, receives a reason on failure
+ * @return false if the file cannot be read, or is not a complete result file
+ */
+bool readResultFile(const std::string& path, std::vector<ResultRecord>& out, std::string* error = nullptr);
+
+#endif // RESULTS_H
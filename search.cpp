@@ -1,16 +1,26 @@
 /**
  * search.cpp
  * 
- * Implementation of three search algorithms for finding books in a collection.
+ * Implementation of six search algorithms for finding books in a collection.
  * Each algorithm searches for a book with matching ISBN, language, and type.
  * 
  * Algorithms provided:
  * 1. Linear search - simple sequential scan
  * 2. Binary search - iterative divide-and-conquer (requires sorted data)
  * 3. Recursive binary search - recursive divide-and-conquer (requires sorted data)
+ * 4. Merge search - batch sort + linear merge (requires sorted data)
+ * 5. Interleaved binary search - a batch searched in groups of lockstep,
+ *    prefetched descents (requires sorted data)
+ * 6. Range search - ISBN run lookup returning the matching records (requires sorted data)
+ * 
+ * The language and type arguments are translated to their interned ids once
+ * per call, so the loops themselves only do integer compares. The loops
+ * live in search_kernels.h as templates; the functions here instantiate
+ * them for std::vector<Book> in the catalog order.
  */
 
 #include "search.h"
+#include "search_kernels.h"
 
 /**
  * Linear search implementation.
@@ -33,22 +43,28 @@
  * @param isbn Target ISBN number
  * @return true if exact match found, false otherwise
  */
-bool linearSearch(const std::vector<Book>& books, const std::string& lang, const std::string& type, size_t isbn) {
-    // Scan through every book in sequence
-    for (const auto& book : books) {
-        // Check if all three attributes match
-        if (book.getLanguage() == lang && book.getType() == type && book.getISBN() == isbn) {
-            return true;  // Found exact match
-        }
-    }
-    return false;  // No match found after checking all books
+bool linearSearch(const std::vector<Book>& books, std::string_view lang, std::string_view type, size_t isbn) {
+    Book key;
+    if (!encodeBook(lang, type, isbn, key)) return false;
+    return linearSearch(books, key);
+}
+
+/**
+ * Linear search on an already-encoded target.
+ * 
+ * @param books Vector of books (can be unsorted)
+ * @param key Encoded book to look for
+ * @return true if exact match found, false otherwise
+ */
+bool linearSearch(const std::vector<Book>& books, const Book& key) {
+    return linearFind<BookOrder>(books.begin(), books.end(), key);
 }
 
 /**
  * Binary search implementation (iterative).
  * 
  * Uses divide-and-conquer strategy to efficiently search sorted data.
- * Repeatedly divides the search range in half based on ISBN comparison.
+ * Repeatedly divides the search range in half based on operator<.
  * 
  * IMPORTANT: Assumes the books vector is sorted by operator<
  * (primary: ISBN, secondary: type, tertiary: language)
@@ -57,7 +73,7 @@ bool linearSearch(const std::vector<Book>& books, const std::string& lang, const
  * 1. Start with left = 0, right = size - 1
  * 2. Calculate midpoint
  * 3. Check if midpoint book matches all criteria
- * 4. If ISBN at midpoint < target ISBN, search right half
+ * 4. If midpoint book < target (operator<), search right half
  * 5. Otherwise, search left half
  * 6. Repeat until match found or search space exhausted
  * 
@@ -70,35 +86,24 @@ bool linearSearch(const std::vector<Book>& books, const std::string& lang, const
  * @param isbn Target ISBN number
  * @return true if exact match found, false otherwise
  */
-bool binarySearch(const std::vector<Book>& books, const std::string& lang, const std::string& type, size_t isbn) {
-    if (books.empty()) return false;
-    
-    size_t left = 0;
-    size_t right = books.size() - 1;
-    
-    // Continue searching while there's a valid range
-    while (left <= right) {
-        // Calculate midpoint (avoids overflow compared to (left+right)/2)
-        size_t mid = left + (right - left) / 2;
-        const Book &b = books[mid];
-        
-        // Check if we found an exact match (all three attributes)
-        if (b.getISBN() == isbn && b.getLanguage() == lang && b.getType() == type) {
-            return true;
-        }
-        
-        // Decide which half to search next based on ISBN comparison
-        if (b.getISBN() < isbn) {
-            // Target is in the right half
-            left = mid + 1;
-        } else {
-            // Target is in the left half
-            if (mid == 0) break; // Avoid underflow on unsigned subtraction
-            right = mid - 1;
-        }
-    }
-    
-    return false;  // Exhausted search space without finding match
+bool binarySearch(const std::vector<Book>& books, std::string_view lang, std::string_view type, size_t isbn) {
+    Book key;
+    if (!encodeBook(lang, type, isbn, key)) return false;
+    return binarySearch(books, key);
+}
+
+/**
+ * Binary search on an already-encoded target.
+ * 
+ * Same algorithm as above; the string overload forwards here after
+ * encoding its arguments.
+ * 
+ * @param books Vector of SORTED books
+ * @param key Encoded book to look for
+ * @return true if exact match found, false otherwise
+ */
+bool binarySearch(const std::vector<Book>& books, const Book& key) {
+    return binaryFind<BookOrder>(books.begin(), books.end(), key);
 }
 
 /**
@@ -110,10 +115,10 @@ bool binarySearch(const std::vector<Book>& books, const std::string& lang, const
  * IMPORTANT: Assumes the books vector is sorted by operator<
  * 
  * Algorithm:
- * 1. Base cases: empty vector or invalid range → return false
+ * 1. Base cases: empty vector, unknown language/type or invalid range → return false
  * 2. Calculate midpoint of current search range
  * 3. Check if midpoint matches all criteria → return true
- * 4. If ISBN at midpoint < target: recursively search right half
+ * 4. If midpoint book < target: recursively search right half
  * 5. Otherwise: recursively search left half
  * 
  * Time complexity: O(log n) - same as iterative version
@@ -127,30 +132,108 @@ bool binarySearch(const std::vector<Book>& books, const std::string& lang, const
  * @param right Right boundary of current search range (inclusive)
  * @return true if exact match found, false otherwise
  */
-bool recursiveBinarySearch(const std::vector<Book>& books, const std::string& lang, const std::string& type, size_t isbn, size_t left, size_t right) {
+bool recursiveBinarySearch(const std::vector<Book>& books, std::string_view lang, std::string_view type, size_t isbn, size_t left, size_t right) {
     // Base case 1: empty vector
     if (books.empty()) return false;
     
-    // Base case 2: invalid range (search space exhausted)
-    if (left > right) return false;
-    
-    // Calculate midpoint of current range
-    size_t mid = left + (right - left) / 2;
-    const Book &b = books[mid];
-    
-    // Check for exact match at midpoint
-    if (b.getISBN() == isbn && b.getLanguage() == lang && b.getType() == type) {
-        return true;
-    }
-    
-    // Recursive case 1: search right half
-    if (b.getISBN() < isbn) {
-        // Ensure we don't go out of bounds
-        if (mid + 1 > right) return false;
-        return recursiveBinarySearch(books, lang, type, isbn, mid + 1, right);
-    }
-    
-    // Recursive case 2: search left half
-    if (mid == 0) return false;  // Avoid underflow
-    return recursiveBinarySearch(books, lang, type, isbn, left, mid - 1);
+    // Encode once; the recursion itself only works on ids
+    Book key;
+    if (!encodeBook(lang, type, isbn, key)) return false;
+    return recursiveBinarySearch(books, key, left, right);
+}
+
+/**
+ * Recursive binary search on an already-encoded target.
+ * 
+ * @param books Vector of SORTED books
+ * @param key Encoded book to look for
+ * @param left Left boundary of current search range (inclusive)
+ * @param right Right boundary of current search range (inclusive)
+ * @return true if exact match found, false otherwise
+ */
+bool recursiveBinarySearch(const std::vector<Book>& books, const Book& key, size_t left, size_t right) {
+    if (books.empty() || right >= books.size()) return false;
+    return recursiveFind<BookOrder>(books.begin(), key, left, right);
+}
+
+/**
+ * Merge search implementation.
+ * 
+ * Algorithm:
+ * 1. Copy the requests together with their original index
+ * 2. Sort the copy by operator< (ties broken by index, which is irrelevant
+ *    for correctness but keeps the order deterministic)
+ * 3. Walk books and sorted requests together: advance the book cursor while
+ *    the current book is smaller than the request, then the request is found
+ *    exactly when the book under the cursor is equal to it
+ * 4. Scatter each answer back to the request's original index
+ * 
+ * Because operator< is a total order consistent with operator==, the book
+ * cursor never has to move backwards, and duplicate requests simply reuse it.
+ * 
+ * Time complexity: O(m log m + n + m)
+ * Space complexity: O(m)
+ * 
+ * @param books Vector of SORTED books
+ * @param requests Requests in any order
+ * @return Found flags in the original request order
+ */
+std::vector<bool> mergeSearch(const std::vector<Book>& books, const std::vector<Book>& requests) {
+    return mergeFind<BookOrder>(books.begin(), books.end(), requests.begin(), requests.end());
+}
+
+/**
+ * ISBN run lookup.
+ * 
+ * Algorithm:
+ * 1. Branchless descent to the first record whose ISBN is not less than
+ *    the target (the only logarithmic part)
+ * 2. Walk forward while the ISBN still matches
+ * 
+ * @param books Vector of SORTED books
+ * @param isbn Target ISBN
+ * @return Records with that ISBN
+ */
+BookRange isbnRange(const std::vector<Book>& books, size_t isbn) {
+    auto run = equalRun<IsbnOrder>(books.begin(), books.end(), isbn);
+    return {run.first, run.second};
+}
+
+/**
+ * Equal-range lookup.
+ * 
+ * Inside the ISBN run records are ordered by (type, language), so the
+ * matches are contiguous: one branchless descent on the full order lands on
+ * the first of them, and the walk forward takes those equal to the key.
+ * 
+ * @param books Vector of SORTED books
+ * @param key Encoded book to look for
+ * @return Records equal to key
+ */
+BookRange equalRange(const std::vector<Book>& books, const Book& key) {
+    auto run = equalRun<BookOrder>(books.begin(), books.end(), key);
+    return {run.first, run.second};
+}
+
+BookRange equalRange(const std::vector<Book>& books, std::string_view lang, std::string_view type, size_t isbn) {
+    Book key;
+    if (!encodeBook(lang, type, isbn, key)) return {books.end(), books.end()};
+    return equalRange(books, key);
+}
+
+/**
+ * Interleaved batch binary search.
+ * 
+ * Runs interleavedFind() over the full catalog order, so the results are
+ * exactly those of binarySearch() on each request.
+ */
+size_t interleavedBinarySearch(const std::vector<Book>& books, const Book* requests, size_t count, uint8_t* found) {
+    size_t total = 0;
+    interleavedFind<BookOrder, kInterleaveGroup>(books.begin(), books.end(), count,
+        [requests](size_t j) -> const Book& { return requests[j]; },
+        [&](size_t j, bool f) {
+            total += f;
+            if (found != nullptr) found[j] = f;
+        });
+    return total;
 }
@@ -2,19 +2,27 @@
  * search.h
  * 
  * Search strategy interface declarations.
- * Provides three different search algorithms for finding books:
+ * Provides six different search algorithms for finding books:
  * - Linear search: O(n) time, no preprocessing required
  * - Binary search: O(log n) time, requires sorted data
  * - Recursive binary search: O(log n) time, recursive implementation
+ * - Merge search: O(n + m log m) for a whole batch of m requests, requires sorted data
+ * - Interleaved binary search: O(m log n) for a batch of m requests, with
+ *   the cache misses of a group of lookups overlapped, requires sorted data
+ * - Range search: O(log n + k) for the k editions of one ISBN, requires sorted data
  * 
  * All search functions are pure computation - they do NOT perform any I/O.
+ * They are thin wrappers over the templates in search_kernels.h, which can
+ * be instantiated for other record types and layouts as well.
  */
 
 #ifndef SEARCH_H
 #define SEARCH_H
 
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 #include "book.h"
 
 /**
@@ -32,7 +40,16 @@
  * @param isbn Target ISBN to match
  * @return true if a book matching ALL three criteria is found, false otherwise
  */
-bool linearSearch(const std::vector<Book>& books, const std::string& lang, const std::string& type, size_t isbn);
+bool linearSearch(const std::vector<Book>& books, std::string_view lang, std::string_view type, size_t isbn);
+
+/**
+ * Linear search on an already-encoded target.
+ * 
+ * @param books Vector of books to search through
+ * @param key Book to match on ISBN, type and language
+ * @return true if a book equal to key is found, false otherwise
+ */
+bool linearSearch(const std::vector<Book>& books, const Book& key);
 
 /**
  * Iterative binary search algorithm.
@@ -49,7 +66,19 @@ bool linearSearch(const std::vector<Book>& books, const std::string& lang, const
  * @param isbn Target ISBN to match
  * @return true if a book matching ALL three criteria is found, false otherwise
  */
-bool binarySearch(const std::vector<Book>& books, const std::string& lang, const std::string& type, size_t isbn);
+bool binarySearch(const std::vector<Book>& books, std::string_view lang, std::string_view type, size_t isbn);
+
+/**
+ * Iterative binary search on an already-encoded target.
+ * 
+ * Same as above, for callers that hold a Book (e.g. from encodeBook())
+ * and want to skip the string-to-id translation.
+ * 
+ * @param books Vector of SORTED books to search through
+ * @param key Book to match on ISBN, type and language
+ * @return true if a book equal to key is found, false otherwise
+ */
+bool binarySearch(const std::vector<Book>& books, const Book& key);
 
 /**
  * Recursive binary search algorithm.
@@ -68,6 +97,115 @@ bool binarySearch(const std::vector<Book>& books, const std::string& lang, const
  * @param right Right boundary index (inclusive) for current search range
  * @return true if a book matching ALL three criteria is found, false otherwise
  */
-bool recursiveBinarySearch(const std::vector<Book>& books, const std::string& lang, const std::string& type, size_t isbn, size_t left, size_t right);
+bool recursiveBinarySearch(const std::vector<Book>& books, std::string_view lang, std::string_view type, size_t isbn, size_t left, size_t right);
+
+/**
+ * Recursive binary search on an already-encoded target.
+ * 
+ * @param books Vector of SORTED books to search through
+ * @param key Book to match on ISBN, type and language
+ * @param left Left boundary index (inclusive) for current search range
+ * @param right Right boundary index (inclusive) for current search range
+ * @return true if a book equal to key is found, false otherwise
+ */
+bool recursiveBinarySearch(const std::vector<Book>& books, const Book& key, size_t left, size_t right);
+
+/**
+ * BookRange - Half-open range [first, last) of records in a sorted vector.
+ */
+struct BookRange {
+    std::vector<Book>::const_iterator first;
+    std::vector<Book>::const_iterator last;
+
+    std::vector<Book>::const_iterator begin() const { return first; }
+    std::vector<Book>::const_iterator end() const { return last; }
+    bool empty() const { return first == last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+};
+
+/**
+ * All editions of one ISBN.
+ * 
+ * Sorting by operator< (ISBN, then type, then language) puts every record
+ * with the same ISBN in one contiguous run. This finds the start of the run
+ * with a single branchless descent on the ISBN and its end with a sequential
+ * walk, which is cheap because a run holds only a handful of editions.
+ * 
+ * Time complexity: O(log n + k) for k editions of the ISBN
+ * 
+ * @param books Vector of SORTED books
+ * @param isbn Target ISBN
+ * @return Records with that ISBN, in (type, language) order; empty if none
+ */
+BookRange isbnRange(const std::vector<Book>& books, size_t isbn);
+
+/**
+ * Range of records equal to key.
+ * 
+ * Descends on the full order to the first record not less than key, then
+ * walks forward over the records equal to it. Unlike binarySearch(), which
+ * only answers yes/no, this returns the matching record(s) themselves;
+ * there is more than one when the catalog holds duplicate copies.
+ * 
+ * Time complexity: O(log n + k) for k editions of the ISBN
+ * 
+ * @param books Vector of SORTED books
+ * @param key Encoded book to look for
+ * @return Records equal to key; empty if none
+ */
+BookRange equalRange(const std::vector<Book>& books, const Book& key);
+
+/**
+ * Range of records matching the given language, type and ISBN.
+ * 
+ * @param books Vector of SORTED books
+ * @param lang Target language
+ * @param type Target type
+ * @param isbn Target ISBN
+ * @return Matching records; empty if none (or if lang/type were never interned)
+ */
+BookRange equalRange(const std::vector<Book>& books, std::string_view lang, std::string_view type, size_t isbn);
+
+/**
+ * Batched sorted-merge search.
+ * 
+ * Answers a whole batch of requests at once: the requests are sorted by
+ * operator< (remembering their original positions) and then merged against
+ * the sorted books in a single forward pass. The pass only moves forward
+ * and gallops over the books between two requests, so a small batch does
+ * not walk the whole catalog.
+ * 
+ * Time complexity: O(m log m + min(n + m, m log(n / m))) for n books and m requests
+ * Space complexity: O(m) for the sorted copy of the requests
+ * 
+ * @param books Vector of SORTED books to search through
+ * @param requests Books to look for, in any order
+ * @return One entry per request, in the ORIGINAL request order:
+ *         true if that request matches a book on all three criteria
+ */
+std::vector<bool> mergeSearch(const std::vector<Book>& books, const std::vector<Book>& requests);
+
+/** Number of lookups interleavedBinarySearch() runs in lockstep. */
+constexpr size_t kInterleaveGroup = 16;
+
+/**
+ * Interleaved (group-prefetched) batch binary search.
+ * 
+ * Answers the requests kInterleaveGroup at a time: the binary-search
+ * descents of a group advance together one level per round, and each
+ * round prefetches every lookup's next probe before any of them is read.
+ * On a catalog larger than the cache the misses of a group overlap instead
+ * of each lookup waiting for its own chain of misses one by one.
+ * 
+ * Time complexity: O(m log n) for n books and m requests
+ * Space complexity: O(1)
+ * 
+ * @param books Vector of SORTED books to search through
+ * @param requests First of count encoded requests
+ * @param count Number of requests
+ * @param found If not null, receives one flag per request (1 if found)
+ * @return Number of requests found
+ */
+size_t interleavedBinarySearch(const std::vector<Book>& books, const Book* requests, size_t count, uint8_t* found);
 
 #endif // SEARCH_H
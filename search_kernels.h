@@ -0,0 +1,282 @@
+/**
+ * search_kernels.h
+ *
+ * Header-only search kernels, templated on the record layout.
+ *
+ * The algorithms behind search.h, written once over a random-access range
+ * [first, last) of any record type and a key-extraction policy. Everything
+ * is visible to the compiler at the call site, so each instantiation is
+ * specialized for its record and key: on Book the comparisons inline down
+ * to integer compares, with no call per probe.
+ *
+ * A key-extraction policy is a stateless struct providing:
+ *   using Key = ...;                                   // What is compared
+ *   static Key key(const Record& r);                   // (or const Key&)
+ *   static bool less(const Key& a, const Key& b);      // Strict weak order
+ * Two keys are equal when neither is less than the other. The range must be
+ * sorted by the policy's order for every kernel except linearFind().
+ *
+ * Example, for a record type of your own:
+ *   struct Edition { uint64_t isbn; uint32_t price; };
+ *   struct EditionIsbn {
+ *       using Key = uint64_t;
+ *       static uint64_t key(const Edition& e) { return e.isbn; }
+ *       static bool less(uint64_t a, uint64_t b) { return a < b; }
+ *   };
+ *   auto it = branchlessLowerBound<EditionIsbn>(v.begin(), v.end(), isbn);
+ */
+
+#ifndef SEARCH_KERNELS_H
+#define SEARCH_KERNELS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "book.h"
+
+/**
+ * BookOrder - The full catalog order: ISBN, then type, then language.
+ */
+struct BookOrder {
+    using Key = Book;
+    static const Book& key(const Book& b) { return b; }
+    static bool less(const Book& a, const Book& b) { return a < b; }
+};
+
+/**
+ * IsbnOrder - ISBN only, so every edition of an ISBN compares equal.
+ */
+struct IsbnOrder {
+    using Key = size_t;
+    static size_t key(const Book& b) { return b.getISBN(); }
+    static bool less(size_t a, size_t b) { return a < b; }
+};
+
+/**
+ * Whether two keys are equal under the policy's order.
+ */
+template <class Policy>
+inline bool keysEqual(const typename Policy::Key& a, const typename Policy::Key& b) {
+    return !Policy::less(a, b) && !Policy::less(b, a);
+}
+
+/**
+ * Sequential scan for a record equal to key. The range may be unsorted.
+ *
+ * Time complexity: O(n)
+ */
+template <class Policy, class It>
+bool linearFind(It first, It last, const typename Policy::Key& key) {
+    for (; first != last; ++first) {
+        if (keysEqual<Policy>(Policy::key(*first), key)) return true;
+    }
+    return false;
+}
+
+/**
+ * Classic iterative binary search with an early exit on a match.
+ *
+ * Steers on the full order, so records sharing part of the key (e.g.
+ * editions of one ISBN) never send it to the wrong side.
+ *
+ * Time complexity: O(log n)
+ */
+template <class Policy, class It>
+bool binaryFind(It first, It last, const typename Policy::Key& key) {
+    size_t left = 0;
+    size_t right = static_cast<size_t>(last - first);  // Half-open [left, right)
+    while (left < right) {
+        size_t mid = left + (right - left) / 2;
+        const auto& k = Policy::key(first[mid]);
+        if (Policy::less(k, key)) {
+            left = mid + 1;
+        } else if (Policy::less(key, k)) {
+            right = mid;
+        } else {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Recursive binary search over the inclusive index range [left, right].
+ *
+ * Time complexity: O(log n)
+ * Space complexity: O(log n) recursion depth
+ */
+template <class Policy, class It>
+bool recursiveFind(It first, const typename Policy::Key& key, size_t left, size_t right) {
+    if (left > right) return false;
+    size_t mid = left + (right - left) / 2;
+    const auto& k = Policy::key(first[mid]);
+    if (Policy::less(k, key)) {
+        if (mid + 1 > right) return false;
+        return recursiveFind<Policy>(first, key, mid + 1, right);
+    }
+    if (Policy::less(key, k)) {
+        if (mid == 0) return false;  // Avoid underflow
+        return recursiveFind<Policy>(first, key, left, mid - 1);
+    }
+    return true;
+}
+
+/**
+ * First record whose key is not less than key (std::lower_bound semantics).
+ *
+ * Branchy version: the loop exit depends on each comparison, which the CPU
+ * must predict. Best when the probes mostly hit cache.
+ *
+ * Time complexity: O(log n)
+ */
+template <class Policy, class It>
+It lowerBoundBy(It first, It last, const typename Policy::Key& key) {
+    return std::partition_point(first, last, [&key](const auto& r) { return Policy::less(Policy::key(r), key); });
+}
+
+/**
+ * First record whose key is not less than key, without data-dependent branches.
+ *
+ * The range shrinks by half every step no matter how the comparison comes
+ * out, so the loop runs exactly ceil(log2 n) times and the comparison only
+ * selects the next base (a conditional move). Nothing is mispredicted, and
+ * the next probe's address can be computed before the current one returns.
+ *
+ * Time complexity: O(log n), with a fixed trip count
+ */
+template <class Policy, class It>
+It branchlessLowerBound(It first, It last, const typename Policy::Key& key) {
+    size_t n = static_cast<size_t>(last - first);
+    if (n == 0) return first;
+    It base = first;
+    while (n > 1) {
+        size_t half = n / 2;
+        base = Policy::less(Policy::key(base[half]), key) ? base + half : base;
+        n -= half;
+    }
+    return base + static_cast<ptrdiff_t>(Policy::less(Policy::key(*base), key));
+}
+
+/**
+ * Exact-match lookup built on branchlessLowerBound().
+ *
+ * Time complexity: O(log n)
+ */
+template <class Policy, class It>
+bool branchlessFind(It first, It last, const typename Policy::Key& key) {
+    It it = branchlessLowerBound<Policy>(first, last, key);
+    return it != last && !Policy::less(key, Policy::key(*it));
+}
+
+/**
+ * Group-prefetched exact-match lookups: Group branchless descents run in
+ * lockstep.
+ *
+ * One binary search is a chain of dependent loads: the next probe is not
+ * known until the current one returns, so a lookup on a catalog far larger
+ * than the cache waits out one full miss per level. Here up to Group
+ * lookups share one loop. Every descent over a range of the same length
+ * takes the same steps, so in each round every lookup advances one level
+ * (a load whose line was already requested), and then every lookup issues
+ * a prefetch for its next probe. The Group misses of a round are in flight
+ * together, and one round costs about one miss instead of Group.
+ *
+ * Results are reported through out(j, found) for j in [0, count), where
+ * key(j) gives the key of lookup j.
+ *
+ * Time complexity: O(count log n), with up to Group misses overlapped
+ */
+template <class Policy, size_t Group, class It, class KeyAt, class Out>
+void interleavedFind(It first, It last, size_t count, KeyAt key, Out out) {
+    size_t n = static_cast<size_t>(last - first);
+    if (n == 0) {
+        for (size_t j = 0; j < count; ++j) out(j, false);
+        return;
+    }
+    It base[Group];
+    for (size_t g = 0; g < count; g += Group) {
+        size_t m = std::min(Group, count - g);
+        for (size_t j = 0; j < m; ++j) base[j] = first;
+        size_t len = n;
+        while (len > 1) {
+            size_t half = len / 2;
+            for (size_t j = 0; j < m; ++j) {
+                base[j] = Policy::less(Policy::key(base[j][half]), key(g + j)) ? base[j] + half : base[j];
+            }
+            len -= half;
+            for (size_t j = 0; j < m; ++j) __builtin_prefetch(&*(base[j] + len / 2));
+        }
+        for (size_t j = 0; j < m; ++j) {
+            It it = base[j] + static_cast<ptrdiff_t>(Policy::less(Policy::key(*base[j]), key(g + j)));
+            out(g + j, it != last && !Policy::less(key(g + j), Policy::key(*it)));
+        }
+    }
+}
+
+/**
+ * Run of records equal to key, as [first, last) iterators.
+ *
+ * One branchless descent finds the start of the run; the end is found by
+ * walking forward, which is cheap when runs are short (a few editions).
+ *
+ * Time complexity: O(log n + k) for a run of k records
+ */
+template <class Policy, class It>
+std::pair<It, It> equalRun(It first, It last, const typename Policy::Key& key) {
+    It begin = branchlessLowerBound<Policy>(first, last, key);
+    It end = begin;
+    while (end != last && !Policy::less(key, Policy::key(*end))) ++end;
+    return {begin, end};
+}
+
+/**
+ * Batched sorted-merge search.
+ *
+ * Sorts (key, original index) pairs for the requests and merges them
+ * against the sorted records in one forward pass. The pass gallops: from
+ * the current record it probes 1, 2, 4, ... records ahead until it passes
+ * the next request, then binary-searches the last step. Records between
+ * two requests are skipped rather than visited, so a batch much smaller
+ * than the catalog (e.g. one thread's chunk of the requests) costs
+ * O(m log(n / m)) instead of a walk over every record.
+ *
+ * Time complexity: O(m log m + min(n + m, m log(n / m))) for n records
+ *                  and m requests
+ * Space complexity: O(m)
+ *
+ * @return One flag per request, in the original request order
+ */
+template <class Policy, class It, class ReqIt>
+std::vector<bool> mergeFind(It first, It last, ReqIt reqFirst, ReqIt reqLast) {
+    using Key = typename Policy::Key;
+    std::vector<std::pair<Key, size_t>> sorted;
+    sorted.reserve(static_cast<size_t>(std::distance(reqFirst, reqLast)));
+    for (size_t i = 0; reqFirst != reqLast; ++reqFirst, ++i) sorted.emplace_back(*reqFirst, i);
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        if (Policy::less(a.first, b.first)) return true;
+        if (Policy::less(b.first, a.first)) return false;
+        return a.second < b.second;
+    });
+
+    std::vector<bool> found(sorted.size(), false);
+    for (const auto& r : sorted) {
+        if (first != last && Policy::less(Policy::key(*first), r.first)) {
+            // Everything before lo is less than the request
+            It lo = first + 1;
+            size_t step = 1;
+            while (step < static_cast<size_t>(last - lo) && Policy::less(Policy::key(*(lo + step)), r.first)) {
+                lo += step + 1;
+                step *= 2;
+            }
+            It hi = step < static_cast<size_t>(last - lo) ? lo + step + 1 : last;
+            first = lowerBoundBy<Policy>(lo, hi, r.first);
+        }
+        if (first == last) break;  // Every remaining request is larger than all records
+        found[r.second] = !Policy::less(r.first, Policy::key(*first));
+    }
+    return found;
+}
+
+#endif // SEARCH_KERNELS_H
@@ -0,0 +1,316 @@
+/**
+ * searcher.cpp
+ *
+ * Implementation of the method-independent search front end.
+ */
+
+#include "searcher.h"
+#include "search.h"
+#include "parallel.h"
+#include <chrono>
+#include <utility>
+
+bool parseSearchMethod(const std::string& choice, SearchMethod& out) {
+    if (choice == "l") out = SearchMethod::Linear;
+    else if (choice == "b") out = SearchMethod::Binary;
+    else if (choice == "r") out = SearchMethod::RecursiveBinary;
+    else if (choice == "m") out = SearchMethod::Merge;
+    else if (choice == "h") out = SearchMethod::Hash;
+    else if (choice == "e") out = SearchMethod::Eytzinger;
+    else if (choice == "c") out = SearchMethod::Columnar;
+    else if (choice == "p") out = SearchMethod::Learned;
+    else if (choice == "i") out = SearchMethod::Interleaved;
+    else if (choice == "z") out = SearchMethod::Compressed;
+    else return false;
+    return true;
+}
+
+bool methodBuildsIndex(SearchMethod method) {
+    return method == SearchMethod::Hash || method == SearchMethod::Eytzinger || method == SearchMethod::Columnar
+        || method == SearchMethod::Learned || method == SearchMethod::Compressed;
+}
+
+bool methodAnswersBatches(SearchMethod method) {
+    return method == SearchMethod::Merge || method == SearchMethod::Interleaved;
+}
+
+/** Books vector of a Searcher that owns a compressed catalog instead. */
+static const std::vector<Book> kNoBooks;
+
+/**
+ * Constructor - builds the index for index-backed methods.
+ */
+Searcher::Searcher(const std::vector<Book>& books, SearchMethod method)
+    : Searcher(books, method, std::nullopt) {}
+
+/**
+ * Constructor - builds the index for index-backed methods, unless a hash
+ * index was supplied.
+ */
+Searcher::Searcher(const std::vector<Book>& books, SearchMethod method, std::optional<BookHashIndex> hashIndex)
+    : books_(books), method_(method) {
+    if (method == SearchMethod::Hash) {
+        if (hashIndex) hashIndex_ = std::move(hashIndex);
+        else hashIndex_.emplace(books);
+    }
+    if (method == SearchMethod::Eytzinger) eytzingerIndex_.emplace(books);
+    else if (method == SearchMethod::Columnar) columns_.emplace(books);
+    else if (method == SearchMethod::Learned) learnedIndex_.emplace(books);
+    else if (method == SearchMethod::Compressed) compressed_.emplace(books);
+}
+
+Searcher::Searcher(CompressedCatalog catalog)
+    : books_(kNoBooks), method_(SearchMethod::Compressed), compressed_(std::move(catalog)) {}
+
+/**
+ * Dispatch one request to the selected algorithm, without the filter.
+ */
+bool Searcher::search(const Book& request) const {
+    switch (method_) {
+    case SearchMethod::Linear:
+        return linearSearch(books_, request);
+    case SearchMethod::RecursiveBinary:
+        return !books_.empty() && recursiveBinarySearch(books_, request, 0, books_.size() - 1);
+    case SearchMethod::Hash:
+        return hashIndex_->contains(request);
+    case SearchMethod::Eytzinger:
+        return eytzingerIndex_->contains(request);
+    case SearchMethod::Columnar:
+        return columns_->contains(request);
+    case SearchMethod::Learned:
+        return learnedIndex_->contains(request);
+    case SearchMethod::Compressed:
+        return compressed_->contains(request);
+    case SearchMethod::Binary:
+    case SearchMethod::Merge:
+    case SearchMethod::Interleaved:
+    default:
+        return binarySearch(books_, request);
+    }
+}
+
+/**
+ * Answer a request without searching, if the cache knows it or the filter
+ * rules it out. Cache hits reach neither the filter nor its counters.
+ *
+ * @return true if found was set
+ */
+bool Searcher::screen(const Book& request, bool& found, FilterStats& counts) const {
+    if (cache_ && cache_->lookup(request, found)) return true;
+    if (filter_ && !filter_->mayContain(request)) {
+        ++counts.rejected;
+        found = false;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Account for a request that was searched: filter counters, and the result
+ * goes into the cache. Filter rejections are not cached; they are cheap
+ * already and would only displace results that cost a search.
+ */
+void Searcher::record(const Book& request, bool found, FilterStats& counts) const {
+    if (filter_) {
+        ++counts.passed;
+        counts.falsePositives += !found;
+    }
+    if (cache_) cache_->insert(request, found);
+}
+
+/**
+ * Cache, filter, then search; counts go to the caller's local counters.
+ */
+bool Searcher::findCounted(const Book& request, FilterStats& counts) const {
+    bool found;
+    if (screen(request, found, counts)) return found;
+    found = search(request);
+    record(request, found, counts);
+    return found;
+}
+
+bool Searcher::find(const Book& request) const {
+    FilterStats counts;
+    bool found = findCounted(request, counts);
+    if (filter_) filterCounters_->add(counts);
+    return found;
+}
+
+/**
+ * Merge search behind the cache and filter: only the requests neither can
+ * answer are sorted and merged.
+ */
+std::vector<bool> Searcher::mergeScreened(const std::vector<Book>& requests, FilterStats& counts) const {
+    if (!filter_ && !cache_) return mergeSearch(books_, requests);
+    std::vector<bool> found(requests.size(), false);
+    std::vector<Book> passed;
+    std::vector<size_t> positions;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        bool f;
+        if (screen(requests[i], f, counts)) {
+            found[i] = f;
+            continue;
+        }
+        passed.push_back(requests[i]);
+        positions.push_back(i);
+    }
+    std::vector<bool> passedFound = mergeSearch(books_, passed);
+    for (size_t j = 0; j < passed.size(); ++j) {
+        found[positions[j]] = passedFound[j];
+        record(passed[j], passedFound[j], counts);
+    }
+    return found;
+}
+
+/**
+ * Interleaved search behind the cache and filter: the requests neither can
+ * answer are gathered into groups of kInterleaveGroup and each group is
+ * searched in lockstep, so screened-out requests do not leave holes in the
+ * groups.
+ */
+size_t Searcher::interleavedScreened(const Book* requests, size_t count, uint8_t* found, FilterStats& counts) const {
+    if (!filter_ && !cache_) return interleavedBinarySearch(books_, requests, count, found);
+    Book group[kInterleaveGroup];
+    size_t slots[kInterleaveGroup];
+    uint8_t flags[kInterleaveGroup];
+    size_t total = 0;
+    for (size_t i = 0; i < count;) {
+        size_t m = 0;
+        for (; i < count && m < kInterleaveGroup; ++i) {
+            bool f;
+            if (screen(requests[i], f, counts)) {
+                total += f;
+                if (found != nullptr) found[i] = f;
+                continue;
+            }
+            group[m] = requests[i];
+            slots[m++] = i;
+        }
+        total += interleavedBinarySearch(books_, group, m, flags);
+        for (size_t k = 0; k < m; ++k) {
+            record(group[k], flags[k], counts);
+            if (found != nullptr) found[slots[k]] = flags[k];
+        }
+    }
+    return total;
+}
+
+std::vector<bool> Searcher::findBatch(const std::vector<Book>& requests) const {
+    FilterStats counts;
+    std::vector<bool> found;
+    if (method_ == SearchMethod::Merge) {
+        found = mergeScreened(requests, counts);
+    } else if (method_ == SearchMethod::Interleaved) {
+        std::vector<uint8_t> flags(requests.size());
+        interleavedScreened(requests.data(), requests.size(), flags.data(), counts);
+        found.assign(flags.begin(), flags.end());
+    } else {
+        found.resize(requests.size());
+        for (size_t i = 0; i < requests.size(); ++i) found[i] = findCounted(requests[i], counts);
+    }
+    if (filter_) filterCounters_->add(counts);
+    return found;
+}
+
+size_t Searcher::countFound(const std::vector<Book>& requests, size_t begin, size_t end) const {
+    return countRange(requests, begin, end, nullptr);
+}
+
+/**
+ * Like countFound(), also storing each request's flag at found[i - begin]
+ * if found is not null.
+ */
+size_t Searcher::countRange(const std::vector<Book>& requests, size_t begin, size_t end, uint8_t* found) const {
+    FilterStats counts;
+    size_t total = 0;
+    if (method_ == SearchMethod::Merge) {
+        std::vector<Book> batch(requests.begin() + begin, requests.begin() + end);
+        std::vector<bool> flags = mergeScreened(batch, counts);
+        for (size_t i = 0; i < flags.size(); ++i) {
+            total += flags[i];
+            if (found != nullptr) found[i] = flags[i];
+        }
+    } else if (method_ == SearchMethod::Interleaved) {
+        total = interleavedScreened(requests.data() + begin, end - begin, found, counts);
+    } else {
+        for (size_t i = begin; i < end; ++i) {
+            bool f = findCounted(requests[i], counts);
+            total += f;
+            if (found != nullptr) found[i - begin] = f;
+        }
+    }
+    if (filter_) filterCounters_->add(counts);
+    return total;
+}
+
+/**
+ * Like countRange(), timing every lookup into a histogram.
+ */
+size_t Searcher::countFoundTimed(const std::vector<Book>& requests, size_t begin, size_t end,
+                                 LatencyHistogram& latency, uint8_t* found) const {
+    using Clock = std::chrono::steady_clock;
+    FilterStats counts;
+    size_t total = 0;
+    Clock::time_point last = Clock::now();
+    for (size_t i = begin; i < end; ++i) {
+        bool f = findCounted(requests[i], counts);
+        total += f;
+        if (found != nullptr) found[i - begin] = f;
+        Clock::time_point now = Clock::now();
+        latency.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count()));
+        last = now;
+    }
+    if (filter_) filterCounters_->add(counts);
+    return total;
+}
+
+size_t Searcher::countFoundParallel(const std::vector<Book>& requests, unsigned threads,
+                                    LatencyHistogram* latency, std::vector<uint8_t>* found) const {
+    if (threads == 0) threads = 1;
+    bool timed = latency != nullptr && !methodAnswersBatches(method_);
+    // One slot (and histogram) per thread, each written only by its thread;
+    // the found flags are split the same way, so threads never share a range
+    std::vector<size_t> counts(threads, 0);
+    std::vector<LatencyHistogram> histograms(timed ? threads : 0);
+    if (found != nullptr) found->resize(requests.size());  // Every entry is overwritten below
+    parallelFor(requests.size(), threads, [&](unsigned t, size_t begin, size_t end) {
+        uint8_t* flags = found != nullptr ? found->data() + begin : nullptr;
+        counts[t] = timed ? countFoundTimed(requests, begin, end, histograms[t], flags)
+                          : countRange(requests, begin, end, flags);
+    });
+    size_t total = 0;
+    for (size_t c : counts) total += c;
+    for (const auto& h : histograms) latency->Merge(h);
+    return total;
+}
+
+void Searcher::enableFilter(const BloomSettings& settings) {
+    if (&books_ != &kNoBooks) {
+        filter_.emplace(books_, settings);
+        return;
+    }
+    filter_.emplace(compressed_->size(), settings);
+    compressed_->forEach([this](const Book& b) { filter_->add(b); });
+}
+
+void Searcher::enableCache(const CacheSettings& settings) {
+    cache_ = std::make_unique<ResultCache>(settings);
+}
+
+CacheStats Searcher::cacheStats() const {
+    return cache_ ? cache_->stats() : CacheStats();
+}
+
+FilterStats Searcher::filterStats() const {
+    FilterStats s;
+    s.rejected = filterCounters_->rejected;
+    s.passed = filterCounters_->passed;
+    s.falsePositives = filterCounters_->falsePositives;
+    return s;
+}
+
+void Searcher::FilterCounters::add(const FilterStats& s) {
+    rejected += s.rejected;
+    passed += s.passed;
+    falsePositives += s.falsePositives;
+}
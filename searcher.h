@@ -0,0 +1,276 @@
+/**
+ * searcher.h
+ *
+ * Method-independent front end over the search algorithms.
+ *
+ * A Searcher is built once for a books vector and a chosen SearchMethod.
+ * It prebuilds whatever index that method needs and then answers encoded
+ * requests, one at a time or as a batch split across threads. Requests are
+ * Books (see encodeBook()), so the hot path never touches the dictionaries
+ * and is safe to call from many threads at once.
+ *
+ * Optionally a Bloom filter over the books sits in front of the method:
+ * every request is tested against it first, and only possible hits reach
+ * the search itself. On miss-heavy traffic most lookups then cost a single
+ * cache-line read.
+ *
+ * Optionally a result cache sits in front of both: on skewed traffic the
+ * hot requests are answered from it without filtering or searching.
+ */
+
+#ifndef SEARCHER_H
+#define SEARCHER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "book.h"
+#include "bloom_filter.h"
+#include "result_cache.h"
+#include "hash_index.h"
+#include "eytzinger_index.h"
+#include "learned_index.h"
+#include "compressed_catalog.h"
+#include "columnar.h"
+#include "Timer.h"
+
+/**
+ * SearchMethod - The search algorithms selectable in SearchNewBooks.
+ */
+enum class SearchMethod {
+    Linear,           // [l] linearSearch
+    Binary,           // [b] binarySearch
+    RecursiveBinary,  // [r] recursiveBinarySearch
+    Merge,            // [m] mergeSearch
+    Hash,             // [h] BookHashIndex
+    Eytzinger,        // [e] EytzingerIndex
+    Columnar,         // [c] BookColumns
+    Learned,          // [p] LearnedIndex (piecewise-linear)
+    Interleaved,      // [i] interleavedBinarySearch (group-prefetched batches)
+    Compressed        // [z] CompressedCatalog (block-delta-encoded ISBNs)
+};
+
+/**
+ * Parse a one-letter method choice ("l", "b", "r", "m", "h", "e", "c", "p", "i", "z").
+ *
+ * @param choice The user's input
+ * @param out Receives the method on success
+ * @return false if choice is not a known method letter
+ */
+bool parseSearchMethod(const std::string& choice, SearchMethod& out);
+
+/**
+ * @param method A search method
+ * @return true if the method prebuilds an index (whose build time is
+ *         reported separately from the search time)
+ */
+bool methodBuildsIndex(SearchMethod method);
+
+/**
+ * @param method A search method
+ * @return true if the method answers a batch of requests as a whole (merge,
+ *         interleaved), so single lookups have no latency of their own
+ */
+bool methodAnswersBatches(SearchMethod method);
+
+/**
+ * FilterStats - What the Bloom filter in front of a Searcher did.
+ */
+struct FilterStats {
+    size_t rejected = 0;        // Requests the filter ruled out (never searched)
+    size_t passed = 0;          // Requests the filter let through to the search
+    size_t falsePositives = 0;  // Passed requests the search then did not find
+};
+
+/**
+ * Searcher - One search method bound to one SORTED books vector.
+ *
+ * The books vector must outlive the Searcher and must not be modified.
+ * A Searcher over a CompressedCatalog owns the catalog and needs no vector.
+ */
+class Searcher {
+public:
+    /**
+     * Bind a method to the books, building its index if it has one.
+     *
+     * @param books Vector of SORTED books
+     * @param method Search method to use
+     */
+    Searcher(const std::vector<Book>& books, SearchMethod method);
+
+    /**
+     * Bind a method to the books, reusing an already-built hash index
+     * (e.g. one restored from a snapshot) instead of building a new one.
+     *
+     * @param books Vector of SORTED books
+     * @param method Search method to use
+     * @param hashIndex Prebuilt index over books; used only by SearchMethod::Hash
+     */
+    Searcher(const std::vector<Book>& books, SearchMethod method, std::optional<BookHashIndex> hashIndex);
+
+    /**
+     * Take over an already-built compressed catalog (SearchMethod::Compressed),
+     * so the books vector it was built from can be freed.
+     *
+     * @param catalog Compressed catalog to search
+     */
+    explicit Searcher(CompressedCatalog catalog);
+
+    /**
+     * Look up a single request.
+     *
+     * Merge and interleaved search have no single-request form; they fall
+     * back to binarySearch.
+     * With a cache or filter enabled, requests the cache holds or the filter
+     * rules out are answered without searching.
+     *
+     * @param request Encoded book to look for
+     * @return true if a book equal to request exists
+     */
+    bool find(const Book& request) const;
+
+    /**
+     * Look up a whole batch of requests.
+     *
+     * Merge search answers the batch as one sorted merge, and interleaved
+     * search in groups of kInterleaveGroup lockstep descents (either over
+     * only the requests the cache and filter, if enabled, cannot answer);
+     * the other methods call find() per request.
+     *
+     * @param requests Encoded requests
+     * @return One flag per request, in request order
+     */
+    std::vector<bool> findBatch(const std::vector<Book>& requests) const;
+
+    /**
+     * Count how many of requests[begin, end) are found.
+     *
+     * Merge search answers the range as one sorted-merge batch and
+     * interleaved search as interleaved groups; the other methods call
+     * find() per request.
+     *
+     * @param requests Encoded requests
+     * @param begin First request index (inclusive)
+     * @param end Last request index (exclusive)
+     * @return Number of requests found
+     */
+    size_t countFound(const std::vector<Book>& requests, size_t begin, size_t end) const;
+
+    /**
+     * Count found requests using several threads.
+     *
+     * The requests are split into one contiguous chunk per thread; each
+     * thread counts its own chunk and the per-thread counts are summed after
+     * the join.
+     *
+     * With a latency histogram, every lookup is timed individually (one
+     * clock read per lookup, shared between consecutive lookups) and the
+     * per-thread histograms are merged into it after the join. Methods that
+     * answer whole batches (see methodAnswersBatches()) have no per-lookup
+     * latency and record nothing.
+     *
+     * With a found vector, each thread also stores one flag per request of
+     * its chunk (a byte store next to the count it already keeps), so the
+     * caller learns which requests matched without a second search pass.
+     *
+     * @param requests Encoded requests
+     * @param threads Number of worker threads
+     * @param latency If not null, receives one sample per lookup
+     * @param found If not null, resized to requests.size() (size it beforehand
+     *        to keep the allocation out of a timed region); entry i is 1 if
+     *        request i was found, 0 otherwise
+     * @return Number of requests found
+     */
+    size_t countFoundParallel(const std::vector<Book>& requests, unsigned threads,
+                              LatencyHistogram* latency = nullptr, std::vector<uint8_t>* found = nullptr) const;
+
+    /**
+     * @return The method this searcher uses
+     */
+    SearchMethod method() const { return method_; }
+
+    /**
+     * Build a Bloom filter over the books (decoded from the compressed
+     * catalog if the Searcher owns one) and consult it on every lookup
+     * from now on. Call before any lookups; it is not safe to call while
+     * other threads are searching.
+     *
+     * @param settings Target false-positive rate and memory cap
+     */
+    void enableFilter(const BloomSettings& settings);
+
+    /**
+     * @return The filter, or nullptr if enableFilter() was not called
+     */
+    const BlockedBloomFilter* filter() const { return filter_ ? &*filter_ : nullptr; }
+
+    /**
+     * @return Filter counters over all lookups so far (all zero without a filter)
+     */
+    FilterStats filterStats() const;
+
+    /**
+     * Put a result cache in front of the filter and the search from now on.
+     * Call before any lookups; it is not safe to call while other threads
+     * are searching.
+     *
+     * The books a Searcher is bound to never change, so its cached results
+     * never go stale; a mutable catalog keeps its own cache in step (see
+     * Catalog::enableCache()).
+     *
+     * @param settings Cache capacity
+     */
+    void enableCache(const CacheSettings& settings);
+
+    /**
+     * @return The cache, or nullptr if enableCache() was not called
+     */
+    const ResultCache* cache() const { return cache_.get(); }
+
+    /**
+     * @return The compressed catalog, or nullptr unless the method is
+     *         SearchMethod::Compressed
+     */
+    const CompressedCatalog* compressedCatalog() const { return compressed_ ? &*compressed_ : nullptr; }
+
+    /**
+     * @return Cache counters over all lookups so far (all zero without a cache)
+     */
+    CacheStats cacheStats() const;
+
+private:
+    /** Shared filter counters; threads add their local counts in one go. */
+    struct FilterCounters {
+        std::atomic<size_t> rejected{0};
+        std::atomic<size_t> passed{0};
+        std::atomic<size_t> falsePositives{0};
+        void add(const FilterStats& s);
+    };
+
+    bool search(const Book& request) const;
+    bool screen(const Book& request, bool& found, FilterStats& counts) const;
+    void record(const Book& request, bool found, FilterStats& counts) const;
+    bool findCounted(const Book& request, FilterStats& counts) const;
+    std::vector<bool> mergeScreened(const std::vector<Book>& requests, FilterStats& counts) const;
+    size_t interleavedScreened(const Book* requests, size_t count, uint8_t* found, FilterStats& counts) const;
+
+    size_t countRange(const std::vector<Book>& requests, size_t begin, size_t end, uint8_t* found) const;
+    size_t countFoundTimed(const std::vector<Book>& requests, size_t begin, size_t end, LatencyHistogram& latency,
+                           uint8_t* found) const;
+
+    const std::vector<Book>& books_;
+    SearchMethod method_;
+    std::optional<BookHashIndex> hashIndex_;
+    std::optional<EytzingerIndex> eytzingerIndex_;
+    std::optional<BookColumns> columns_;
+    std::optional<LearnedIndex> learnedIndex_;
+    std::optional<CompressedCatalog> compressed_;
+    std::optional<BlockedBloomFilter> filter_;
+    std::unique_ptr<FilterCounters> filterCounters_ = std::make_unique<FilterCounters>();
+    std::unique_ptr<ResultCache> cache_;
+};
+
+#endif // SEARCHER_H
@@ -0,0 +1,216 @@
+/**
+ * server.cpp
+ *
+ * Implementation of the stdin / Unix domain socket request server.
+ */
+
+#include "server.h"
+#include "loader.h"
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <poll.h>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/** Bytes requested per read(); a batch is whatever one read returns. */
+static const size_t kReadBytes = 64 * 1024;
+
+/** How often the accept loop checks the stop flag, in milliseconds. */
+static const int kStopPollMs = 100;
+
+/**
+ * Write all of buf, retrying short writes.
+ *
+ * Sockets are written with MSG_NOSIGNAL so a client that disconnects early
+ * gives EPIPE instead of killing the process; other descriptors fall back
+ * to write().
+ */
+static bool writeAll(int fd, const std::string& buf) {
+    size_t done = 0;
+    while (done < buf.size()) {
+        ssize_t n = ::send(fd, buf.data() + done, buf.size() - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == ENOTSOCK) n = ::write(fd, buf.data() + done, buf.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * Answer every line in text as one batch and append the responses.
+ */
+static void answerLines(const Searcher& searcher, std::string_view text, std::string& response, ServerStats* stats) {
+    enum class Result : uint8_t { Search, NotFound, Malformed };
+    std::vector<std::string_view> lines;
+    std::vector<Result> results;
+    std::vector<Book> keys;
+
+    size_t p = 0;
+    while (p < text.size()) {
+        size_t nl = text.find('\n', p);
+        size_t end = nl == std::string_view::npos ? text.size() : nl;
+        std::string_view line = text.substr(p, end - p);
+        p = end + 1;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);  // Tolerate CRLF clients
+        if (line.empty()) continue;
+
+        lines.push_back(line);
+        Book key;
+        switch (encodeRequestRecord(line, key)) {
+        case RequestRecord::Malformed:
+            results.push_back(Result::Malformed);
+            break;
+        case RequestRecord::Unknown:
+            results.push_back(Result::NotFound);
+            break;
+        case RequestRecord::Encoded:
+            results.push_back(Result::Search);
+            keys.push_back(key);
+            break;
+        }
+    }
+
+    std::vector<bool> found = searcher.findBatch(keys);
+    size_t k = 0, hits = 0, malformed = 0;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        response.append(lines[i]);
+        if (results[i] == Result::Malformed) {
+            response.append("\tmalformed\n");
+            ++malformed;
+        } else if (results[i] == Result::Search && found[k++]) {
+            response.append("\tfound\n");
+            ++hits;
+        } else {
+            response.append("\tnot found\n");
+        }
+    }
+    if (stats != nullptr) {
+        stats->requests += lines.size() - malformed;
+        stats->found += hits;
+        stats->malformed += malformed;
+    }
+}
+
+/**
+ * Serve one connection.
+ *
+ * Algorithm:
+ * 1. read() whatever is available (up to kReadBytes) after any partial line
+ *    carried over from the previous read
+ * 2. Answer all complete lines as one batch, carry the partial last line
+ * 3. Write the batch's responses back in one go
+ * 4. At end of input, answer the carried line too (it has no newline)
+ */
+bool serveConnection(const Searcher& searcher, int inFd, int outFd, ServerStats* stats) {
+    if (stats != nullptr) ++stats->connections;
+    std::string buffer;
+    std::string response;
+    while (true) {
+        size_t old = buffer.size();
+        buffer.resize(old + kReadBytes);
+        ssize_t n = ::read(inFd, &buffer[old], kReadBytes);
+        if (n < 0) {
+            buffer.resize(old);
+            if (errno == EINTR) continue;
+            return false;
+        }
+        buffer.resize(old + static_cast<size_t>(n));
+
+        size_t complete = n == 0 ? buffer.size() : buffer.rfind('\n') + 1;  // npos + 1 == 0
+        response.clear();
+        answerLines(searcher, std::string_view(buffer).substr(0, complete), response, stats);
+        buffer.erase(0, complete);
+        if (!response.empty() && !writeAll(outFd, response)) return false;
+        if (n == 0) return true;
+    }
+}
+
+/**
+ * Connection - A client being served on its own thread.
+ *
+ * The accept loop owns the descriptor and closes it after joining the
+ * thread, so shutting it down at stop time can never hit a reused fd.
+ */
+struct Connection {
+    int fd;
+    std::thread thread;
+    std::atomic<bool> done{false};
+};
+
+bool serveUnixSocket(const Searcher& searcher, const std::string& path, const std::atomic<bool>& stop,
+                     ServerStats* stats, std::string* error) {
+    auto fail = [&](const char* what) {
+        if (error != nullptr) *error = std::string(what) + ": " + std::strerror(errno);
+        return false;
+    };
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return fail("socket path");
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    int listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) return fail("socket");
+    ::unlink(path.c_str());
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        bool result = fail("bind");
+        ::close(listenFd);
+        return result;
+    }
+    if (::listen(listenFd, SOMAXCONN) != 0) {
+        bool result = fail("listen");
+        ::close(listenFd);
+        ::unlink(path.c_str());
+        return result;
+    }
+
+    // Accept until stopped, reaping finished connections as we go
+    std::vector<std::unique_ptr<Connection>> connections;
+    while (!stop) {
+        pollfd pfd{listenFd, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, kStopPollMs);
+        for (size_t i = 0; i < connections.size();) {
+            if (connections[i]->done) {
+                connections[i]->thread.join();
+                ::close(connections[i]->fd);
+                connections[i] = std::move(connections.back());
+                connections.pop_back();
+            } else {
+                ++i;
+            }
+        }
+        if (ready <= 0) continue;  // Timeout, or EINTR from a signal that may have set stop
+
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        auto conn = std::make_unique<Connection>();
+        conn->fd = fd;
+        Connection* c = conn.get();
+        conn->thread = std::thread([&searcher, stats, c] {
+            serveConnection(searcher, c->fd, c->fd, stats);
+            c->done = true;
+        });
+        connections.push_back(std::move(conn));
+    }
+
+    // Shut down open connections so their blocked reads return, then join
+    for (auto& c : connections) {
+        ::shutdown(c->fd, SHUT_RDWR);
+        c->thread.join();
+        ::close(c->fd);
+    }
+    ::close(listenFd);
+    ::unlink(path.c_str());
+    return true;
+}
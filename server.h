@@ -0,0 +1,69 @@
+/**
+ * server.h
+ *
+ * Long-running request server over a prepared catalog.
+ *
+ * The catalog is loaded, sorted and indexed once; requests then arrive over
+ * a byte stream (stdin, or a connection to a Unix domain socket) for as
+ * long as the process runs, so preparation is paid once for any number of
+ * client batches.
+ *
+ * Protocol (line-based, same record format as requests.dat):
+ *   request:  isbn,language,type\n         (any number per message)
+ *   response: isbn,language,type\tfound\n  (or "not found" / "malformed")
+ *
+ * Every non-empty request line gets exactly one response line, in order.
+ * A client may send one request at a time or many at once: all complete
+ * lines received by one read are answered as one batch (one
+ * Searcher::findBatch() call) and written back with one write, and the
+ * connection ends when the client closes its side.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include "searcher.h"
+
+/**
+ * ServerStats - Counters over all connections of a server.
+ */
+struct ServerStats {
+    std::atomic<size_t> connections{0};  // Connections served (1 for a stdin session)
+    std::atomic<size_t> requests{0};     // Well-formed request lines
+    std::atomic<size_t> found{0};        // Requests that matched a book
+    std::atomic<size_t> malformed{0};    // Non-empty lines that could not be parsed
+};
+
+/**
+ * Answer requests read from one descriptor until end of input.
+ *
+ * @param searcher Searcher over the SORTED catalog
+ * @param inFd Descriptor to read requests from
+ * @param outFd Descriptor to write responses to (may equal inFd for a socket)
+ * @param stats If not null, counters to add to
+ * @return false if reading or writing failed before end of input
+ */
+bool serveConnection(const Searcher& searcher, int inFd, int outFd, ServerStats* stats = nullptr);
+
+/**
+ * Serve clients on a Unix domain socket until stop becomes true.
+ *
+ * An existing file at path is replaced, and the socket file is removed on
+ * return. Each client gets its own thread, so slow clients do not hold up
+ * others; the Searcher is shared by all of them. When stop is set, open
+ * connections are shut down and their threads joined before returning.
+ *
+ * @param searcher Searcher over the SORTED catalog
+ * @param path Filesystem path of the socket
+ * @param stop Set (e.g. from a signal handler) to make the server return
+ * @param stats If not null, counters to add to
+ * @param error If not null, receives a description of why the server could not start
+ * @return false if the socket cannot be created, bound or listened on
+ */
+bool serveUnixSocket(const Searcher& searcher, const std::string& path, const std::atomic<bool>& stop,
+                     ServerStats* stats = nullptr, std::string* error = nullptr);
+
+#endif // SERVER_H
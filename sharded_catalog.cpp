@@ -0,0 +1,205 @@
+/**
+ * sharded_catalog.cpp
+ *
+ * Implementation of the NUMA-sharded catalog.
+ */
+
+#include "sharded_catalog.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+
+/**
+ * Parse a kernel CPU/node list such as "0-3,8,10-11".
+ */
+static std::vector<int> parseIdList(const std::string& text) {
+    std::vector<int> ids;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty() || item == "\n") continue;
+        size_t dash = item.find('-');
+        int first = std::atoi(item.c_str());
+        int last = dash == std::string::npos ? first : std::atoi(item.c_str() + dash + 1);
+        for (int id = first; id <= last; ++id) ids.push_back(id);
+    }
+    return ids;
+}
+
+static bool readLine(const std::string& path, std::string& line) {
+    std::ifstream in(path);
+    return static_cast<bool>(std::getline(in, line));
+}
+
+/**
+ * Read the online nodes and each node's CPU list from sysfs, keeping only
+ * the CPUs in this process's affinity mask.
+ */
+std::vector<NumaNode> numaTopology() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool haveMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    auto isAllowed = [&](int cpu) { return !haveMask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)); };
+
+    std::vector<NumaNode> nodes;
+    std::string line;
+    if (readLine("/sys/devices/system/node/online", line)) {
+        for (int id : parseIdList(line)) {
+            std::string cpuList;
+            if (!readLine("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist", cpuList)) continue;
+            NumaNode node{id, {}};
+            for (int cpu : parseIdList(cpuList)) {
+                if (isAllowed(cpu)) node.cpus.push_back(cpu);
+            }
+            if (!node.cpus.empty()) nodes.push_back(std::move(node));
+        }
+    }
+    if (nodes.empty()) {
+        NumaNode node{0, {}};
+        int cpus = haveMask ? CPU_SETSIZE : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        for (int cpu = 0; cpu < cpus; ++cpu) {
+            if (isAllowed(cpu)) node.cpus.push_back(cpu);
+        }
+        nodes.push_back(std::move(node));
+    }
+    return nodes;
+}
+
+/**
+ * Restrict the calling thread to the CPUs of node.
+ */
+static void pinToNode(const NumaNode& node) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : node.cpus) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/**
+ * Build the shards.
+ *
+ * Algorithm:
+ * 1. Discover the nodes
+ * 2. Choose cut points at even record counts, moved forward to ISBN run
+ *    boundaries; record each shard's first ISBN in the router
+ * 3. On one thread per shard, pinned to its node: copy the shard's records
+ *    and build its Searcher, so both are first-touched on that node
+ */
+ShardedCatalog::ShardedCatalog(const std::vector<Book>& books, unsigned shards, SearchMethod method, bool pin)
+    : nodes_(numaTopology()), pin_(pin) {
+    if (shards == 0) shards = 1;
+
+    // Step 2: cut points
+    std::vector<size_t> cuts = {0};
+    size_t n = books.size();
+    for (unsigned s = 1; s < shards; ++s) {
+        size_t cut = std::max(n * s / shards, cuts.back() + 1);
+        while (cut < n && books[cut].getISBN() == books[cut - 1].getISBN()) ++cut;
+        if (cut >= n) break;
+        cuts.push_back(cut);
+    }
+    cuts.push_back(n);
+    for (size_t s = 0; s + 1 < cuts.size(); ++s) {
+        auto shard = std::make_unique<Shard>();
+        shard->node = s % nodes_.size();
+        shards_.push_back(std::move(shard));
+        router_.push_back(n == 0 ? 0 : books[cuts[s]].getISBN());
+    }
+
+    // Step 3: build each shard on its node
+    onShardNodes([&](size_t s) {
+        Shard& shard = *shards_[s];
+        shard.books.assign(books.begin() + cuts[s], books.begin() + cuts[s + 1]);
+        shard.searcher.emplace(shard.books, method);
+    });
+}
+
+void ShardedCatalog::enableFilter(const BloomSettings& settings) {
+    size_t total = 0;
+    for (const auto& shard : shards_) total += shard->books.size();
+    onShardNodes([&](size_t s) {
+        BloomSettings share = settings;
+        if (settings.maxBytes > 0 && total > 0) {
+            share.maxBytes = std::max<size_t>(1, settings.maxBytes * shards_[s]->books.size() / total);
+        }
+        shards_[s]->searcher->enableFilter(share);
+    });
+}
+
+void ShardedCatalog::enableCache(const CacheSettings& settings) {
+    CacheSettings share{std::max<size_t>(1, settings.capacity / std::max<size_t>(1, shards_.size()))};
+    onShardNodes([&](size_t s) { shards_[s]->searcher->enableCache(share); });
+}
+
+/**
+ * Run fn(s) for every shard, each on its own thread pinned to the shard's
+ * node, and wait for all of them.
+ */
+void ShardedCatalog::onShardNodes(const std::function<void(size_t)>& fn) const {
+    std::vector<std::thread> workers;
+    workers.reserve(shards_.size());
+    for (size_t s = 0; s < shards_.size(); ++s) {
+        workers.emplace_back([this, &fn, s] {
+            if (pin_) pinToNode(nodes_[shards_[s]->node]);
+            fn(s);
+        });
+    }
+    for (auto& w : workers) w.join();
+}
+
+/**
+ * Last shard whose first ISBN is <= isbn. The router holds one entry per
+ * shard, so it stays in a cache line or two and the search is a handful
+ * of compares.
+ */
+size_t ShardedCatalog::shardOf(size_t isbn) const {
+    return std::upper_bound(router_.begin() + 1, router_.end(), isbn) - router_.begin() - 1;
+}
+
+bool ShardedCatalog::find(const Book& request) const {
+    return shards_[shardOf(request.getISBN())]->searcher->find(request);
+}
+
+size_t ShardedCatalog::countFound(const std::vector<Book>& requests, std::vector<uint8_t>* found) const {
+    // Step 1: route and bucket, remembering each request's original index
+    size_t count = shards_.size();
+    std::vector<uint32_t> route(requests.size());
+    std::vector<size_t> offsets(count + 1, 0);
+    for (size_t i = 0; i < requests.size(); ++i) {
+        route[i] = static_cast<uint32_t>(shardOf(requests[i].getISBN()));
+        ++offsets[route[i] + 1];
+    }
+    for (size_t s = 0; s < count; ++s) offsets[s + 1] += offsets[s];
+    std::vector<std::vector<Book>> buckets(count);
+    std::vector<size_t> order(requests.size());
+    std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+    for (size_t s = 0; s < count; ++s) buckets[s].reserve(offsets[s + 1] - offsets[s]);
+    for (size_t i = 0; i < requests.size(); ++i) {
+        buckets[route[i]].push_back(requests[i]);
+        order[next[route[i]]++] = i;
+    }
+    if (found != nullptr) found->resize(requests.size());
+
+    // Step 2: one pinned worker per shard; each writes only its own
+    // requests' flags, so no two workers touch the same entry
+    std::vector<size_t> counts(count, 0);
+    onShardNodes([&](size_t s) {
+        if (buckets[s].empty()) return;
+        std::vector<uint8_t> flags;
+        counts[s] = shards_[s]->searcher->countFoundParallel(buckets[s], 1, nullptr, found != nullptr ? &flags : nullptr);
+        if (found == nullptr) return;
+        for (size_t j = 0; j < flags.size(); ++j) (*found)[order[offsets[s] + j]] = flags[j];
+    });
+
+    // Step 3: reduce
+    size_t total = 0;
+    for (size_t c : counts) total += c;
+    return total;
+}
@@ -0,0 +1,175 @@
+/**
+ * sharded_catalog.h
+ *
+ * Catalog partitioned by ISBN range into shards, each kept on one NUMA node.
+ *
+ * A single books vector lives wherever its pages were first touched,
+ * usually the node of the thread that loaded it, so on a multi-socket
+ * machine every probe from a thread on another socket is a remote memory
+ * access. Here the sorted books are cut into N contiguous ISBN ranges. Each
+ * shard is copied, and its search index built, by a thread pinned to the
+ * shard's node, so Linux's first-touch policy places the shard's pages in
+ * that node's memory. Shards are dealt to nodes round-robin.
+ *
+ * A small router array holds the first ISBN of every shard. A batch of
+ * requests is routed once, bucketed per shard, and each bucket is answered
+ * by a worker pinned to its shard's node: the random probes into the
+ * records and index are all node-local, and only the bucket itself (read
+ * once, sequentially) crosses the interconnect.
+ *
+ * A Bloom filter and a result cache can be put in front of every shard's
+ * search, as on a single Searcher; each shard gets its own, built on its
+ * node, so the whole lookup path stays node-local.
+ *
+ * The topology comes from /sys/devices/system/node, so no NUMA library is
+ * needed. On a single-node machine (or without that directory) every shard
+ * is on node 0 and pinning only restricts workers to the allowed CPUs.
+ */
+
+#ifndef SHARDED_CATALOG_H
+#define SHARDED_CATALOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "book.h"
+#include "searcher.h"
+
+/**
+ * NumaNode - One NUMA node and the CPUs of it this process may run on.
+ */
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;
+};
+
+/**
+ * Discover the NUMA nodes this process can run on.
+ *
+ * @return Nodes with at least one allowed CPU, in id order; a single node 0
+ *         holding every allowed CPU if the topology cannot be read
+ */
+std::vector<NumaNode> numaTopology();
+
+/**
+ * ShardedCatalog - Sorted books split into per-node ISBN-range shards.
+ *
+ * Every shard owns a copy of its records and its own Searcher, so the
+ * source vector may be released once the catalog is built.
+ */
+class ShardedCatalog {
+public:
+    /**
+     * Partition the books and build each shard on its node.
+     *
+     * Cut points are spread evenly by record count and then moved forward
+     * to the next change of ISBN, so all editions of an ISBN share a shard
+     * and routing by ISBN alone is exact. Shards that would end up empty
+     * (very long runs, or fewer ISBNs than shards) are dropped.
+     *
+     * @param books Vector of SORTED books
+     * @param shards Number of shards requested (0 is treated as 1)
+     * @param method Search method each shard uses
+     * @param pin Pin build and search workers to their shard's node
+     */
+    ShardedCatalog(const std::vector<Book>& books, unsigned shards, SearchMethod method, bool pin = true);
+
+    ShardedCatalog(const ShardedCatalog&) = delete;
+    ShardedCatalog& operator=(const ShardedCatalog&) = delete;
+
+    /**
+     * @param isbn ISBN to route
+     * @return Index of the only shard that can hold isbn
+     */
+    size_t shardOf(size_t isbn) const;
+
+    /**
+     * Look up a single request on the calling thread (no node affinity).
+     *
+     * @param request Encoded book to look for
+     * @return true if a book equal to request exists
+     */
+    bool find(const Book& request) const;
+
+    /**
+     * Count found requests, one pinned worker per shard.
+     *
+     * Algorithm:
+     * 1. Route every request and bucket it by shard (counting sort, so
+     *    each bucket keeps request order)
+     * 2. Start one worker per non-empty bucket, pinned to the shard's
+     *    node, which answers the bucket with the shard's Searcher
+     * 3. Sum the per-shard counts after the join
+     *
+     * @param requests Encoded requests
+     * @param found If not null, resized to requests.size(); entry i is 1 if
+     *        request i was found, 0 otherwise
+     * @return Number of requests found
+     */
+    size_t countFound(const std::vector<Book>& requests, std::vector<uint8_t>* found = nullptr) const;
+
+    /**
+     * Build a Bloom filter over every shard, on the shard's node. A memory
+     * cap is split between the shards by record count. Not safe to call
+     * while requests are being counted.
+     *
+     * @param settings Target false-positive rate and memory cap (whole catalog)
+     */
+    void enableFilter(const BloomSettings& settings);
+
+    /**
+     * Put a result cache in front of every shard's search. The capacity is
+     * split evenly between the shards. Not safe to call while requests are
+     * being counted.
+     *
+     * @param settings Cache capacity (whole catalog)
+     */
+    void enableCache(const CacheSettings& settings);
+
+    /**
+     * @return Number of shards
+     */
+    size_t shards() const { return shards_.size(); }
+
+    /**
+     * @param s Shard index
+     * @return The shard's Searcher (for its filter and cache counters)
+     */
+    const Searcher& shardSearcher(size_t s) const { return *shards_[s]->searcher; }
+
+    /**
+     * @param s Shard index
+     * @return The shard's records (sorted)
+     */
+    const std::vector<Book>& shardBooks(size_t s) const { return shards_[s]->books; }
+
+    /**
+     * @param s Shard index
+     * @return Id of the NUMA node the shard was placed on
+     */
+    int shardNode(size_t s) const { return nodes_[shards_[s]->node].id; }
+
+    /**
+     * @return The nodes shards are dealt to
+     */
+    const std::vector<NumaNode>& nodes() const { return nodes_; }
+
+private:
+    struct Shard {
+        std::vector<Book> books;
+        std::optional<Searcher> searcher;  // Bound to books, built on the shard's node
+        size_t node;                       // Index into nodes_
+    };
+
+    void onShardNodes(const std::function<void(size_t)>& fn) const;
+
+    std::vector<NumaNode> nodes_;
+    bool pin_;
+    std::vector<size_t> router_;  // router_[s] = first ISBN of shard s (router_[0] is unused)
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+#endif // SHARDED_CATALOG_H
@@ -0,0 +1,241 @@
+/**
+ * snapshot.cpp
+ *
+ * Implementation of the binary catalog snapshot.
+ */
+
+#include "snapshot.h"
+#include "dictionary.h"
+#include "loader.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+static const char kMagic[8] = {'B', 'O', 'O', 'K', 'S', 'N', 'A', 'P'};
+
+static_assert(sizeof(SnapshotHeader) % 16 == 0, "sections after the header must stay 16-byte aligned");
+
+/** Bytes of records copied out of the mapping between two MappedFile::discard() calls. */
+static const size_t kCopyWindowBytes = size_t(8) << 20;
+
+/**
+ * Checksum - Checksum of a byte range, fed in pieces.
+ *
+ * Consumes 8 bytes per step (multiply-rotate mixing), so verifying a large
+ * snapshot runs close to memory speed. Not cryptographic; it only detects
+ * truncated or corrupted files. Every piece but the last must be a
+ * multiple of 8 bytes long (snapshot sections are 16-byte aligned).
+ */
+class Checksum {
+public:
+    /** @param size Total bytes that will be added */
+    explicit Checksum(size_t size) : h_(0x9E3779B97F4A7C15ULL ^ size) {}
+
+    void add(const char* data, size_t size) {
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t w;
+            std::memcpy(&w, data + i, 8);
+            h_ = (h_ ^ w) * 0xFF51AFD7ED558CCDULL;
+            h_ = (h_ << 31) | (h_ >> 33);
+        }
+        for (; i < size; ++i) h_ = (h_ ^ static_cast<unsigned char>(data[i])) * 0x100000001B3ULL;
+    }
+
+    uint64_t value() const { return h_ ^ (h_ >> 33); }
+
+private:
+    uint64_t h_;
+};
+
+static uint64_t checksum(const char* data, size_t size) {
+    Checksum sum(size);
+    sum.add(data, size);
+    return sum.value();
+}
+
+/**
+ * Append a dictionary's strings (length-prefixed) to a buffer.
+ */
+static void appendStrings(std::string& buf, const StringDictionary& dict, size_t count) {
+    for (uint32_t id = 0; id < count; ++id) {
+        std::string_view s = dict.name(id);
+        uint32_t len = static_cast<uint32_t>(s.size());
+        buf.append(reinterpret_cast<const char*>(&len), sizeof(len));
+        buf.append(s);
+    }
+}
+
+/**
+ * Write a snapshot.
+ *
+ * The payload (dictionaries, records, hash slots) is assembled in memory so
+ * the checksum can be stored in the header, then written in one go.
+ */
+bool writeSnapshot(const std::string& path, const std::vector<Book>& books, bool sorted, const BookHashIndex* hashIndex) {
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kSnapshotVersion;
+    header.flags = (sorted ? kSnapshotSorted : 0) | (hashIndex != nullptr ? kSnapshotHasHashIndex : 0);
+    header.recordCount = books.size();
+    header.languageCount = languageDictionary().size();
+    header.typeCount = typeDictionary().size();
+
+    // Dictionary section, padded to keep the records 16-byte aligned
+    std::string payload;
+    appendStrings(payload, languageDictionary(), header.languageCount);
+    appendStrings(payload, typeDictionary(), header.typeCount);
+    payload.resize((payload.size() + 15) / 16 * 16, '\0');
+    header.stringBytes = payload.size();
+
+    payload.append(reinterpret_cast<const char*>(books.data()), books.size() * sizeof(Book));
+    if (hashIndex != nullptr) {
+        const std::vector<Book>& slots = hashIndex->slots();
+        header.hashSlotCount = slots.size();
+        header.hashSize = hashIndex->size();
+        payload.append(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(Book));
+    }
+    header.checksum = checksum(payload.data(), payload.size());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return false;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+    return static_cast<bool>(out);
+}
+
+bool isSnapshotFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(kMagic)];
+    if (!in.read(magic, sizeof(magic))) return false;
+    return std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+/**
+ * Read one dictionary's strings and intern them, recording old id -> new id.
+ *
+ * @return false if the section runs past its end
+ */
+static bool readStrings(const char*& p, const char* end, size_t count, StringDictionary& dict, std::vector<uint32_t>& remap, bool& identity) {
+    remap.resize(count);
+    for (size_t id = 0; id < count; ++id) {
+        uint32_t len;
+        if (end - p < static_cast<ptrdiff_t>(sizeof(len))) return false;
+        std::memcpy(&len, p, sizeof(len));
+        p += sizeof(len);
+        if (end - p < static_cast<ptrdiff_t>(len)) return false;
+        remap[id] = dict.intern(std::string_view(p, len));
+        identity = identity && remap[id] == id;
+        p += len;
+    }
+    return true;
+}
+
+/**
+ * Copy count records out of the mapping and add them to the checksum, one
+ * window at a time. Each window's pages are dropped once copied, so the
+ * mapping and the copy are never both fully resident.
+ */
+static void copyRecords(MappedFile& file, const Book* from, size_t count, Checksum& sum, std::vector<Book>& to) {
+    const size_t window = kCopyWindowBytes / sizeof(Book);
+    to.clear();
+    to.reserve(count);
+    for (size_t i = 0; i < count; i += window) {
+        size_t end = std::min(count, i + window);
+        sum.add(reinterpret_cast<const char*>(from + i), (end - i) * sizeof(Book));
+        to.insert(to.end(), from + i, from + end);
+        file.discard(reinterpret_cast<const char*>(from + end) - file.data());
+    }
+}
+
+static bool fail(std::string* error, const char* message) {
+    if (error != nullptr) *error = message;
+    return false;
+}
+
+/**
+ * Load a snapshot.
+ *
+ * Algorithm:
+ * 1. Map the file and validate the header and section sizes
+ * 2. Copy the records and hash slots out of the mapping, checksumming the
+ *    payload on the way, and verify the checksum
+ * 3. Intern the saved dictionaries and build old -> new id maps
+ * 4. Re-encode the records if the ids moved
+ * 5. Restore the hash index (rebuilding it if the ids moved)
+ *
+ * The records end up in a vector, because every search method takes a
+ * std::vector<Book>; they are not searched in place in the mapping. The
+ * copy still costs O(n) at startup, but step 2 drops the mapped pages
+ * behind it, so the peak is the copy plus one window of the file rather
+ * than twice the catalog.
+ */
+bool loadSnapshot(const std::string& path, Snapshot& out, std::string* error) {
+    // Step 1: map and validate
+    MappedFile file;
+    if (!file.open(path)) return fail(error, "cannot open file");
+    if (file.size() < sizeof(SnapshotHeader)) return fail(error, "file too small for a snapshot header");
+
+    SnapshotHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) return fail(error, "not a snapshot file");
+    if (header.version != kSnapshotVersion) return fail(error, "unsupported snapshot version");
+
+    const char* payload = file.data() + sizeof(SnapshotHeader);
+    size_t payloadSize = file.size() - sizeof(SnapshotHeader);
+    bool hasIndex = (header.flags & kSnapshotHasHashIndex) != 0;
+    size_t maxBooks = payloadSize / sizeof(Book);
+    bool sizesOk = header.stringBytes % 16 == 0 && header.stringBytes <= payloadSize
+                   && header.recordCount <= maxBooks && header.hashSlotCount <= maxBooks
+                   && header.stringBytes + (header.recordCount + header.hashSlotCount) * sizeof(Book) == payloadSize;
+    bool indexOk = !hasIndex || (header.hashSlotCount > 0 && (header.hashSlotCount & (header.hashSlotCount - 1)) == 0
+                                 && header.hashSize < header.hashSlotCount);
+    if (!sizesOk || !indexOk) return fail(error, "snapshot sections do not match the file size");
+
+    // Step 2: copy and checksum
+    const char* stringsEnd = payload + header.stringBytes;
+    const Book* records = reinterpret_cast<const Book*>(stringsEnd);
+    Checksum sum(payloadSize);
+    sum.add(payload, header.stringBytes);
+    copyRecords(file, records, header.recordCount, sum, out.books);
+    std::vector<Book> slots;
+    copyRecords(file, records + header.recordCount, header.hashSlotCount, sum, slots);
+    if (sum.value() != header.checksum) {
+        out.books.clear();
+        return fail(error, "snapshot checksum mismatch");
+    }
+
+    // Step 3: dictionaries
+    const char* p = payload;
+    std::vector<uint32_t> languageMap, typeMap;
+    bool identity = true;
+    if (!readStrings(p, stringsEnd, header.languageCount, languageDictionary(), languageMap, identity)
+        || !readStrings(p, stringsEnd, header.typeCount, typeDictionary(), typeMap, identity)) {
+        return fail(error, "corrupt snapshot dictionary");
+    }
+    for (uint32_t id : typeMap) {
+        if (id >= kTypeIdLimit) return fail(error, "too many distinct book types");
+    }
+
+    // Step 4: records
+    out.sorted = (header.flags & kSnapshotSorted) != 0;
+    if (!identity) {
+        for (auto& b : out.books) {
+            if (b.getLanguageId() >= languageMap.size() || b.getTypeId() >= typeMap.size()) {
+                return fail(error, "snapshot record refers to an unknown dictionary id");
+            }
+            b = Book(b.getISBN(), languageMap[b.getLanguageId()], static_cast<uint16_t>(typeMap[b.getTypeId()]));
+        }
+        // New ids may order languages differently
+        out.sorted = false;
+    }
+
+    // Step 5: hash index (slot positions depend on the ids, so rebuild if they moved)
+    out.hashIndex.reset();
+    if (hasIndex) {
+        if (identity) out.hashIndex.emplace(std::move(slots), header.hashSize);
+        else out.hashIndex.emplace(out.books);
+    }
+    return true;
+}
@@ -0,0 +1,103 @@
+/**
+ * snapshot.h
+ *
+ * Versioned binary snapshot of a parsed, sorted catalog.
+ *
+ * A snapshot is written once from a loaded catalog and can then be mapped
+ * at startup instead of re-parsing newbooks.dat and re-sorting it. The file
+ * holds the language/type dictionaries, the packed 16-byte Book records in
+ * sorted order and, optionally, the slot array of a BookHashIndex.
+ *
+ * Layout (native byte order, every section 16-byte aligned):
+ *   SnapshotHeader
+ *   dictionary strings: for each language, then each type:
+ *       uint32_t length, followed by that many bytes
+ *   Book records[recordCount]
+ *   Book hashSlots[hashSlotCount]   (only if kSnapshotHasHashIndex)
+ *
+ * The checksum covers everything after the header.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "book.h"
+#include "hash_index.h"
+
+/** Current snapshot format version; bumped whenever the layout changes. */
+constexpr uint32_t kSnapshotVersion = 1;
+
+/** Header flag: records are sorted by Book::operator<. */
+constexpr uint32_t kSnapshotSorted = 1u << 0;
+
+/** Header flag: a BookHashIndex slot array follows the records. */
+constexpr uint32_t kSnapshotHasHashIndex = 1u << 1;
+
+/**
+ * SnapshotHeader - Fixed-size header at offset 0 of a snapshot file.
+ */
+struct SnapshotHeader {
+    char magic[8];            // "BOOKSNAP"
+    uint32_t version;         // kSnapshotVersion
+    uint32_t flags;           // kSnapshot* flags
+    uint64_t recordCount;     // Number of Book records
+    uint64_t languageCount;   // Number of language strings
+    uint64_t typeCount;       // Number of type strings
+    uint64_t stringBytes;     // Size of the dictionary section, including padding
+    uint64_t hashSlotCount;   // Number of hash slots (0 without an index)
+    uint64_t hashSize;        // Number of occupied hash slots
+    uint64_t checksum;        // Checksum of everything after the header
+    uint64_t reserved;        // Zero; pads the header to a multiple of 16 bytes
+};
+
+/**
+ * Snapshot - A catalog loaded from a snapshot file.
+ */
+struct Snapshot {
+    std::vector<Book> books;                 // Records, using this process's dictionary ids
+    bool sorted = false;                     // Header's kSnapshotSorted flag
+    std::optional<BookHashIndex> hashIndex;  // Restored index, if the file had one
+};
+
+/**
+ * Write a snapshot.
+ *
+ * @param path Output file
+ * @param books Catalog to save (sorted if sorted is true)
+ * @param sorted Whether books is sorted by operator<
+ * @param hashIndex Index to save alongside the records, or nullptr
+ * @return false if the file cannot be written
+ */
+bool writeSnapshot(const std::string& path, const std::vector<Book>& books, bool sorted, const BookHashIndex* hashIndex);
+
+/**
+ * Check whether a file starts with the snapshot magic.
+ *
+ * @param path File to check
+ * @return true if the file looks like a snapshot
+ */
+bool isSnapshotFile(const std::string& path);
+
+/**
+ * Map and load a snapshot.
+ *
+ * The header is validated (magic, version, section sizes against the file
+ * size) and the checksum is verified before anything is used. The saved
+ * dictionaries are interned into this process's dictionaries; when that
+ * gives the same ids as when the snapshot was written (always true for a
+ * fresh process), records and hash slots are copied out of the mapping as
+ * they are. Otherwise the records are re-encoded and the hash index is
+ * rebuilt.
+ *
+ * @param path Snapshot file
+ * @param out Receives the catalog
+ * @param error If not null, receives a description of why loading failed
+ * @return false if the file cannot be read or is not a valid snapshot
+ */
+bool loadSnapshot(const std::string& path, Snapshot& out, std::string* error = nullptr);
+
+#endif // SNAPSHOT_H
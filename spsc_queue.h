@@ -0,0 +1,123 @@
+/**
+ * spsc_queue.h
+ *
+ * Bounded lock-free queue between exactly one producer thread and exactly
+ * one consumer thread.
+ *
+ * The queue is a power-of-two ring of slots with two monotonically
+ * increasing counters: the producer owns head_, the consumer owns tail_.
+ * Each side only ever writes its own counter and reads the other one with
+ * acquire ordering, so a push or pop is a couple of plain loads and one
+ * release store - no locks, no compare-and-swap. The counters sit on
+ * separate cache lines so the two threads do not false-share.
+ *
+ * The blocking push()/pop() wrappers spin with std::this_thread::yield(),
+ * which also keeps a pipeline making progress when it has more stages than
+ * cores.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * SpscQueue - Single-producer single-consumer bounded ring buffer.
+ *
+ * The producer calls push()/tryPush() and finally close(); the consumer
+ * calls pop()/tryPop(). pop() returns false once the queue is closed and
+ * drained, which is how end of stream is signalled.
+ */
+template <class T>
+class SpscQueue {
+public:
+    /**
+     * @param capacity Minimum number of slots; rounded up to a power of two
+     */
+    explicit SpscQueue(size_t capacity) {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        slots_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * Enqueue without waiting (producer only).
+     *
+     * @param value Item to move into the queue; left untouched on failure
+     * @return false if the queue is full
+     */
+    bool tryPush(T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == slots_.size()) return false;
+        slots_[head & mask_] = std::move(value);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Enqueue, waiting while the queue is full (producer only).
+     *
+     * @param value Item to move into the queue
+     */
+    void push(T value) {
+        while (!tryPush(value)) std::this_thread::yield();
+    }
+
+    /**
+     * Dequeue without waiting (consumer only).
+     *
+     * @param out Receives the oldest item
+     * @return false if the queue is empty
+     */
+    bool tryPop(T& out) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+        out = std::move(slots_[tail & mask_]);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Dequeue, waiting while the queue is empty but still open (consumer only).
+     *
+     * @param out Receives the oldest item
+     * @return false once the queue is closed and every item has been popped
+     */
+    bool pop(T& out) {
+        while (true) {
+            if (tryPop(out)) return true;
+            if (closed_.load(std::memory_order_acquire)) {
+                // Items pushed before close() are visible now; drain them first
+                return tryPop(out);
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * Mark the end of the stream (producer only, after its last push).
+     */
+    void close() { closed_.store(true, std::memory_order_release); }
+
+    /**
+     * @return Number of slots
+     */
+    size_t capacity() const { return slots_.size(); }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> head_{0};  // Next slot to write; producer-owned
+    alignas(64) std::atomic<size_t> tail_{0};  // Next slot to read; consumer-owned
+    alignas(64) std::atomic<bool> closed_{false};
+};
+
+#endif // SPSC_QUEUE_H
@@ -1,12 +1,72 @@
 #include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <tuple>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 #include "book.h"
+#include "book_sort.h"
+#include "dictionary.h"
 #include "search.h"
+#include "hash_index.h"
+#include "eytzinger_index.h"
+#include "columnar.h"
+#include "searcher.h"
+#include "loader.h"
+#include "snapshot.h"
+#include "catalog.h"
+#include "pipeline.h"
+#include "server.h"
+#include "search_kernels.h"
+#include "bloom_filter.h"
+#include "learned_index.h"
+#include "arena.h"
+#include "results.h"
+#include "sharded_catalog.h"
+#include "result_cache.h"
+#include "compressed_catalog.h"
+#include "Timer.h"
 
 using std::vector;
 
+// Count every global allocation, so tests can assert that a code path makes none
+static std::atomic<size_t> allocationCount{0};
+
+void* operator new(size_t size) {
+    ++allocationCount;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+// GCC sees the inlined free() pair with new-expressions elsewhere and
+// flags it; the replacement new above does use malloc
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+#pragma GCC diagnostic pop
+
 int count_matches_linear(const vector<Book>& newbooks, const vector<Book>& requests) {
     int cnt = 0;
     for (const auto &r : requests) {
@@ -36,12 +96,56 @@ int count_matches_recursive_binary(vector<Book> newbooks, const vector<Book>& re
     return cnt;
 }
 
+int count_matches_merge(vector<Book> newbooks, const vector<Book>& requests) {
+    std::sort(newbooks.begin(), newbooks.end());
+    vector<bool> found = mergeSearch(newbooks, requests);
+    assert(found.size() == requests.size());
+    int cnt = static_cast<int>(std::count(found.begin(), found.end(), true));
+    std::cout << "Merge search found " << cnt << " matches." << std::endl;
+    return cnt;
+}
+
+int count_matches_hash(const vector<Book>& newbooks, const vector<Book>& requests) {
+    BookHashIndex index(newbooks);
+    int cnt = 0;
+    for (const auto &r : requests) {
+        if (hashSearch(index, r.getLanguage(), r.getType(), r.getISBN())) ++cnt;
+    }
+    std::cout << "Hash search found " << cnt << " matches." << std::endl;
+    return cnt;
+}
+
+int count_matches_eytzinger(vector<Book> newbooks, const vector<Book>& requests) {
+    std::sort(newbooks.begin(), newbooks.end());
+    EytzingerIndex index(newbooks);
+    int cnt = 0;
+    for (const auto &r : requests) {
+        if (eytzingerSearch(index, r.getLanguage(), r.getType(), r.getISBN())) ++cnt;
+    }
+    std::cout << "Eytzinger search found " << cnt << " matches." << std::endl;
+    return cnt;
+}
+
+int count_matches_columnar(const vector<Book>& newbooks, const vector<Book>& requests) {
+    BookColumns columns(newbooks);
+    int cnt = 0;
+    for (const auto &r : requests) {
+        if (columnarSearch(columns, r.getLanguage(), r.getType(), r.getISBN())) ++cnt;
+    }
+    std::cout << "Columnar search found " << cnt << " matches." << std::endl;
+    return cnt;
+}
+
 void test_all_hit() {
     vector<Book> newbooks = { Book("english","new",123) };
     vector<Book> requests = { Book("english","new",123) };
     assert(count_matches_linear(newbooks, requests) == 1);
     assert(count_matches_binary(newbooks, requests) == 1);
     assert(count_matches_recursive_binary(newbooks, requests) == 1);
+    assert(count_matches_merge(newbooks, requests) == 1);
+    assert(count_matches_hash(newbooks, requests) == 1);
+    assert(count_matches_eytzinger(newbooks, requests) == 1);
+    assert(count_matches_columnar(newbooks, requests) == 1);
     std::cout << "All hit tests passed!" << std::endl;
 }
 
@@ -51,6 +155,10 @@ void test_all_miss() {
     assert(count_matches_linear(newbooks, requests) == 0);
     assert(count_matches_binary(newbooks, requests) == 0);
     assert(count_matches_recursive_binary(newbooks, requests) == 0);
+    assert(count_matches_merge(newbooks, requests) == 0);
+    assert(count_matches_hash(newbooks, requests) == 0);
+    assert(count_matches_eytzinger(newbooks, requests) == 0);
+    assert(count_matches_columnar(newbooks, requests) == 0);
     std::cout << "All miss tests passed!" << std::endl;
 }
 
@@ -60,6 +168,10 @@ void test_empty_input() {
     assert(count_matches_linear(newbooks, requests) == 0);
     assert(count_matches_binary(newbooks, requests) == 0);
     assert(count_matches_recursive_binary(newbooks, requests) == 0);
+    assert(count_matches_merge(newbooks, requests) == 0);
+    assert(count_matches_hash(newbooks, requests) == 0);
+    assert(count_matches_eytzinger(newbooks, requests) == 0);
+    assert(count_matches_columnar(newbooks, requests) == 0);
     std::cout << "Empty input tests passed!" << std::endl;
 }
 
@@ -69,6 +181,10 @@ void test_duplicate_newbooks() {
     assert(count_matches_linear(newbooks, requests) == 1);
     assert(count_matches_binary(newbooks, requests) == 1);
     assert(count_matches_recursive_binary(newbooks, requests) == 1);
+    assert(count_matches_merge(newbooks, requests) == 1);
+    assert(count_matches_hash(newbooks, requests) == 1);
+    assert(count_matches_eytzinger(newbooks, requests) == 1);
+    assert(count_matches_columnar(newbooks, requests) == 1);
     std::cout << "Duplicate newbooks tests passed!" << std::endl;
 }
 
@@ -78,6 +194,10 @@ void test_type_mismatch() {
     assert(count_matches_linear(newbooks, requests) == 0);
     assert(count_matches_binary(newbooks, requests) == 0);
     assert(count_matches_recursive_binary(newbooks, requests) == 0);
+    assert(count_matches_merge(newbooks, requests) == 0);
+    assert(count_matches_hash(newbooks, requests) == 0);
+    assert(count_matches_eytzinger(newbooks, requests) == 0);
+    assert(count_matches_columnar(newbooks, requests) == 0);
     std::cout << "Type mismatch tests passed!" << std::endl;
 }
 
@@ -87,6 +207,10 @@ void test_language_mismatch() {
     assert(count_matches_linear(newbooks, requests) == 0);
     assert(count_matches_binary(newbooks, requests) == 0);
     assert(count_matches_recursive_binary(newbooks, requests) == 0);
+    assert(count_matches_merge(newbooks, requests) == 0);
+    assert(count_matches_hash(newbooks, requests) == 0);
+    assert(count_matches_eytzinger(newbooks, requests) == 0);
+    assert(count_matches_columnar(newbooks, requests) == 0);
     std::cout << "Language mismatch tests passed!" << std::endl;
 }
 
@@ -102,6 +226,1120 @@ void test_book_comparators() {
     std::cout << "Book comparator tests passed!" << std::endl;
 }
 
+void test_interned_fields() {
+    Book a("english", "new", 7);
+    Book b("english", "hardcover", 7);
+    Book c("english", "paperback", 7);
+    assert(sizeof(Book) == 16);
+    assert(a.getTypeId() == static_cast<uint16_t>(BookType::New));
+    assert(b.getTypeId() >= static_cast<uint16_t>(BookType::Other));
+    assert(a.getLanguage() == "english" && b.getType() == "hardcover");
+    assert(a.getLanguageId() == b.getLanguageId());
+    assert(!(b == c)); // distinct unknown types stay distinct
+    assert(a < b && a < c);
+    vector<Book> newbooks = { b };
+    vector<Book> requests = { c, Book("klingon", "hardcover", 7) };
+    assert(count_matches_linear(newbooks, requests) == 0);
+    assert(count_matches_binary(newbooks, requests) == 0);
+    assert(count_matches_recursive_binary(newbooks, requests) == 0);
+    // Searching for strings no book uses must not grow the dictionaries
+    size_t langs = languageDictionary().size();
+    assert(!linearSearch(newbooks, "esperanto", "hardcover", 7));
+    assert(languageDictionary().size() == langs);
+    std::cout << "Interned field tests passed!" << std::endl;
+}
+
+void test_merge_preserves_request_order() {
+    vector<Book> newbooks = { Book("english","new",5), Book("french","used",2), Book("english","new",9) };
+    vector<Book> requests = {
+        Book("english","new",9), Book("english","new",1), Book("french","used",2),
+        Book("english","new",9), Book("english","used",5), Book("english","new",5)
+    };
+    std::sort(newbooks.begin(), newbooks.end());
+    vector<bool> found = mergeSearch(newbooks, requests);
+    vector<bool> expected = { true, false, true, true, false, true };
+    assert(found == expected);
+
+    // A few requests against a large catalog make the pass gallop: across
+    // long gaps, onto the first and last books, and past either end
+    vector<Book> catalog;
+    for (size_t i = 1; i <= 100000; ++i) catalog.push_back(Book("english", "new", i * 2));
+    vector<Book> sparse = {
+        Book("english","new",200000), Book("english","new",0), Book("english","new",2),
+        Book("english","new",99999), Book("english","new",131072), Book("english","new",200002),
+        Book("english","new",4), Book("english","new",199998), Book("english","new",3)
+    };
+    found = mergeSearch(catalog, sparse);
+    expected = { true, false, true, false, true, false, true, true, false };
+    assert(found == expected);
+    std::cout << "Merge order tests passed!" << std::endl;
+}
+
+void test_hash_index_many() {
+    vector<Book> newbooks;
+    for (size_t i = 0; i < 5000; ++i) newbooks.push_back(Book(i % 3 ? "english" : "french", i % 2 ? "used" : "new", i * 7));
+    newbooks.push_back(newbooks.front());  // duplicate is stored once
+    BookHashIndex index(newbooks);
+    assert(index.size() == 5000);
+    assert(index.capacity() >= 2 * index.size());
+    for (size_t i = 0; i < 5000; ++i) {
+        assert(index.contains(newbooks[i]));
+        assert(!index.contains(Book(i % 3 ? "english" : "french", i % 2 ? "used" : "new", i * 7 + 1)));
+        assert(!index.contains(Book(i % 3 ? "english" : "french", i % 2 ? "new" : "used", i * 7)));
+    }
+    std::cout << "Hash index tests passed!" << std::endl;
+}
+
+void test_eytzinger_lower_bound() {
+    // Every size from 0 to 70 exercises full and partial last tree levels
+    for (size_t n = 0; n <= 70; ++n) {
+        vector<Book> newbooks;
+        for (size_t i = 0; i < n; ++i) {
+            newbooks.push_back(Book("english", "new", 10 * i));
+            newbooks.push_back(Book("english", "used", 10 * i));  // two editions per ISBN
+        }
+        std::sort(newbooks.begin(), newbooks.end());
+        EytzingerIndex index(newbooks);
+        assert(index.size() == n);
+        for (size_t q = 0; q <= 10 * n + 10; ++q) {
+            size_t expected = std::lower_bound(newbooks.begin(), newbooks.end(), Book("english", "new", q)) - newbooks.begin();
+            assert(index.lowerBound(q) == expected);
+        }
+        for (const auto& b : newbooks) assert(index.contains(b));
+        assert(!index.contains(Book("english", "digital", 0)));
+    }
+    std::cout << "Eytzinger index tests passed!" << std::endl;
+}
+
+void test_columnar_kernels() {
+    // Unsorted rows with the target ISBN at every offset of a SIMD block,
+    // including a same-ISBN decoy of the wrong type just before it
+    for (size_t n = 0; n < 40; ++n) {
+        for (size_t at = 0; at < n; ++at) {
+            vector<Book> newbooks;
+            for (size_t i = 0; i < n; ++i) newbooks.push_back(Book("english", "new", 1000 - i));
+            newbooks[at] = Book("english", "used", 42);
+            if (at > 0) newbooks[at - 1] = Book("english", "digital", 42);
+            BookColumns columns(newbooks);
+            for (ScanKernel k : { ScanKernel::Scalar, ScanKernel::SSE42, ScanKernel::AVX2 }) {
+                if (!scanKernelSupported(k)) continue;
+                assert(columns.contains(Book("english", "used", 42), k));
+                assert(!columns.contains(Book("english", "new", 42), k));
+                assert(!columns.contains(Book("english", "used", 43), k));
+            }
+        }
+    }
+    std::cout << "Columnar kernel tests passed (best kernel: " << scanKernelName(bestScanKernel()) << ")!" << std::endl;
+}
+
+void test_parallel_searcher() {
+    vector<Book> newbooks;
+    vector<Book> requests;
+    for (size_t i = 0; i < 1000; ++i) {
+        newbooks.push_back(Book(i % 2 ? "english" : "french", i % 3 ? "new" : "used", i * 3));
+        requests.push_back(Book(i % 2 ? "english" : "french", i % 3 ? "new" : "used", i * 3 + (i % 4 == 0)));
+    }
+    std::sort(newbooks.begin(), newbooks.end());
+    for (const char* m : { "l", "b", "r", "m", "h", "e", "c", "p" }) {
+        SearchMethod method;
+        assert(parseSearchMethod(m, method));
+        Searcher searcher(newbooks, method);
+        size_t serial = searcher.countFound(requests, 0, requests.size());
+        assert(serial == 750);
+        for (unsigned threads : { 1u, 2u, 7u, 2000u }) {
+            assert(searcher.countFoundParallel(requests, threads) == serial);
+        }
+    }
+    SearchMethod method;
+    assert(!parseSearchMethod("x", method));
+    std::cout << "Parallel searcher tests passed!" << std::endl;
+}
+
+void test_loader() {
+    Book b;
+    assert(parseBookRecord("9780132350884,english,new", b));
+    assert(b == Book("english", "new", 9780132350884ULL));
+    assert(parseBookRecord("5,,", b) && b.getLanguage().empty() && b.getType().empty());
+    assert(!parseBookRecord("", b));
+    assert(!parseBookRecord("123,english", b));
+    assert(!parseBookRecord(",english,new", b));
+    assert(!parseBookRecord("12x,english,new", b));
+    assert(!parseBookRecord("-1,english,new", b));
+    assert(!parseBookRecord("99999999999999999999999,english,new", b));
+    assert(parseBookRecord("7,english,used\r", b) && b == Book("english", "used", 7));
+    assert(encodeRequestRecord("7,english,used\r", b) == RequestRecord::Encoded && b == Book("english", "used", 7));
+    assert(!parseBookRecord("\r", b));
+
+    const char* path = "test_loader_tmp.dat";
+    {
+        std::ofstream f(path);
+        f << "1,english,new\n\nbad line\n2,french,used\r\n\r\n3,spanish,digital";  // CRLF, no final newline
+    }
+    vector<Book> books;
+    LoadStats stats;
+    assert(loadBookFile(path, books, &stats));
+    assert(books.size() == 3 && stats.records == 3 && stats.malformed == 1);
+    assert(books[1] == Book("french", "used", 2) && books[2] == Book("spanish", "digital", 3));
+    assert(stats.bytes > 0);
+    std::remove(path);
+    assert(!loadBookFile("does_not_exist.dat", books));
+    std::cout << "Loader tests passed!" << std::endl;
+}
+
+void test_snapshot_roundtrip() {
+    vector<Book> newbooks;
+    for (size_t i = 0; i < 300; ++i) newbooks.push_back(Book(i % 2 ? "english" : "german", i % 3 ? "new" : "hardcover", 1000 - i));
+    std::sort(newbooks.begin(), newbooks.end());
+    BookHashIndex index(newbooks);
+
+    const char* path = "test_snapshot_tmp.snap";
+    assert(writeSnapshot(path, newbooks, true, &index));
+    assert(isSnapshotFile(path));
+
+    Snapshot snap;
+    std::string error;
+    assert(loadSnapshot(path, snap, &error));
+    assert(snap.sorted && snap.books == newbooks);
+    assert(snap.hashIndex && snap.hashIndex->size() == index.size());
+    for (const auto& b : newbooks) assert(snap.hashIndex->contains(b));
+    assert(!snap.hashIndex->contains(Book("english", "new", 5000)));
+
+    // Flip one byte of the payload: the checksum must catch it
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(sizeof(SnapshotHeader) + 40);
+        f.put('\x7f');
+    }
+    assert(!loadSnapshot(path, snap, &error));
+    assert(error == "snapshot checksum mismatch");
+    std::remove(path);
+
+    assert(!isSnapshotFile("does_not_exist.snap"));
+    assert(!loadSnapshot("does_not_exist.snap", snap));
+    std::cout << "Snapshot tests passed!" << std::endl;
+}
+
+void test_catalog_updates() {
+    const char* langs[] = { "english", "french" };
+    const char* types[] = { "new", "used", "digital" };
+    vector<Book> initial;
+    std::set<std::tuple<size_t, int, int>> model;
+    std::mt19937 rng(7);
+    for (int i = 0; i < 2000; ++i) {
+        int l = rng() % 2, t = rng() % 3;
+        size_t isbn = rng() % 1500;
+        initial.push_back(Book(langs[l], types[t], isbn));
+        model.insert({isbn, l, t});
+    }
+    Catalog catalog(initial);
+    assert(catalog.size() == model.size());
+
+    // Random inserts/erases, enough to trigger several compactions
+    for (int step = 0; step < 20000; ++step) {
+        int l = rng() % 2, t = rng() % 3;
+        size_t isbn = rng() % 1500;
+        Book b(langs[l], types[t], isbn);
+        bool changed;
+        if (rng() % 2) changed = catalog.insert(b) == model.insert({isbn, l, t}).second;
+        else changed = catalog.erase(b) == (model.erase({isbn, l, t}) == 1);
+        assert(changed);
+        assert(catalog.size() == model.size());
+        assert(catalog.contains(b) == (model.count({isbn, l, t}) == 1));
+    }
+    for (size_t isbn = 0; isbn < 1500; ++isbn) {
+        for (int l = 0; l < 2; ++l) {
+            for (int t = 0; t < 3; ++t) {
+                assert(catalog.contains(Book(langs[l], types[t], isbn)) == (model.count({isbn, l, t}) == 1));
+            }
+        }
+    }
+    catalog.compact();
+    assert(catalog.pendingUpdates() == 0);
+    assert(catalog.books().size() == model.size());
+    assert(std::is_sorted(catalog.books().begin(), catalog.books().end()));
+    std::cout << "Catalog update tests passed!" << std::endl;
+}
+
+void test_equal_range_editions() {
+    // Two editions of one ISBN (plus a third): the midpoint lands on
+    // "french new", left of the target, and steering on the ISBN alone
+    // would search the wrong half
+    vector<Book> books = {
+        Book("english", "new", 100), Book("french", "new", 100), Book("english", "used", 100),
+    };
+    std::sort(books.begin(), books.end());
+    for (const auto& b : books) {
+        assert(binarySearch(books, b));
+        assert(recursiveBinarySearch(books, b, 0, books.size() - 1));
+        BookRange r = equalRange(books, b);
+        assert(r.size() == 1 && *r.begin() == b);
+    }
+    assert(!binarySearch(books, "french", "used", 100));
+    assert(equalRange(books, "french", "used", 100).empty());
+    assert(equalRange(books, "klingon", "new", 100).empty());
+
+    // Every edition of every ISBN, with duplicate copies of some
+    const char* langs[] = { "english", "french", "spanish" };
+    const char* types[] = { "new", "used", "digital" };
+    books.clear();
+    for (size_t isbn = 10; isbn < 40; isbn += 3) {
+        for (int t = 0; t < 3; ++t) {
+            for (int l = 0; l < 3; ++l) {
+                if ((isbn + t + l) % 4 == 0) continue;  // Leave some editions out
+                books.push_back(Book(langs[l], types[t], isbn));
+                if (l == 1) books.push_back(Book(langs[l], types[t], isbn));
+            }
+        }
+    }
+    std::sort(books.begin(), books.end());
+    for (size_t isbn = 8; isbn < 42; ++isbn) {
+        BookRange run = isbnRange(books, isbn);
+        assert(run.size() == static_cast<size_t>(std::count_if(books.begin(), books.end(),
+                                                               [isbn](const Book& b) { return b.getISBN() == isbn; })));
+        for (const auto& b : run) assert(b.getISBN() == isbn);
+        for (int t = 0; t < 3; ++t) {
+            for (int l = 0; l < 3; ++l) {
+                Book key(langs[l], types[t], isbn);
+                size_t expected = std::count(books.begin(), books.end(), key);
+                BookRange r = equalRange(books, key);
+                assert(r.size() == expected);
+                for (const auto& b : r) assert(b == key);
+                assert(binarySearch(books, key) == (expected > 0));
+                assert(recursiveBinarySearch(books, key, 0, books.size() - 1) == (expected > 0));
+            }
+        }
+    }
+    std::cout << "Equal range tests passed!" << std::endl;
+}
+
+void test_stream_search() {
+    vector<Book> newbooks;
+    for (size_t i = 0; i < 500; ++i) newbooks.push_back(Book(i % 2 ? "english" : "french", i % 3 ? "new" : "used", i * 2));
+    std::sort(newbooks.begin(), newbooks.end());
+
+    const char* inPath = "test_stream_in_tmp.dat";
+    const char* outPath = "test_stream_out_tmp.dat";
+    vector<std::string> expected;
+    {
+        std::ofstream f(inPath);
+        for (size_t i = 0; i < 700; ++i) {
+            std::string line = std::to_string(i) + "," + (i % 2 ? "english" : "french") + "," + (i % 3 ? "new" : "used");
+            if (i % 50 == 7) line = "not a record";
+            if (i % 50 == 9) line = std::to_string(i) + ",klingon,new";  // Unknown language
+            if (i % 100 == 11) line += std::string(300, 'x');          // Longer than a chunk
+            f << line << (i % 70 == 0 ? "\n\n" : i % 40 == 13 ? "\r\n" : "\n");  // Empty lines are skipped; CRLF is tolerated
+            Book b;
+            std::string result = "not found";
+            if (!parseBookRecord(line, b)) result = "malformed";
+            else if (binarySearch(newbooks, b)) result = "found";
+            expected.push_back(line + "\t" + result);
+        }
+        f << "1398,english,new";  // No final newline
+        expected.push_back("1398,english,new\tnot found");
+    }
+    for (const char* m : { "b", "m", "h" }) {
+        SearchMethod method;
+        assert(parseSearchMethod(m, method));
+        Searcher searcher(newbooks, method);
+        for (unsigned workers : { 1u, 3u }) {
+            for (size_t chunkBytes : { size_t(7), size_t(4096), kStreamChunkBytes }) {
+                StreamStats stats;
+                assert(streamSearch(searcher, inPath, outPath, workers, &stats, chunkBytes));
+                std::ifstream f(outPath);
+                vector<std::string> lines;
+                for (std::string line; std::getline(f, line);) lines.push_back(line);
+                assert(lines == expected);
+                assert(stats.requests + stats.malformed == expected.size());
+                assert(stats.found == static_cast<size_t>(std::count_if(expected.begin(), expected.end(), [](const std::string& l) {
+                    return l.size() > 6 && l.compare(l.size() - 6, 6, "\tfound") == 0;
+                })));
+            }
+        }
+    }
+    std::remove(inPath);
+    std::remove(outPath);
+    Searcher searcher(newbooks, SearchMethod::Binary);
+    assert(!streamSearch(searcher, "does_not_exist.dat", outPath, 1));
+    std::cout << "Streaming search tests passed!" << std::endl;
+}
+
+void test_instrumentation() {
+    // Percentiles of 1..100000 are exact up to the 1/32 bucket width
+    LatencyHistogram a, b;
+    for (uint64_t v = 1; v <= 100000; ++v) (v % 2 ? a : b).Record(v);
+    a.Merge(b);
+    assert(a.Count() == 100000 && a.Min() == 1 && a.Max() == 100000);
+    for (double p : { 50.0, 90.0, 99.0, 99.9 }) {
+        double exact = p / 100.0 * 100000;
+        double got = static_cast<double>(a.Percentile(p));
+        assert(got >= exact && got <= exact * (1 + 1.0 / 32));
+    }
+    assert(a.Percentile(100) == 100000);
+    LatencyHistogram small;
+    for (uint64_t v : { 3, 3, 7, 31 }) small.Record(v);
+    assert(small.Percentile(50) == 3 && small.Percentile(75) == 7 && small.Percentile(100) == 31);
+    assert(LatencyHistogram().Percentile(99) == 0);
+    small.Record(UINT64_MAX);
+    assert(small.Max() == UINT64_MAX && small.Percentile(100) == UINT64_MAX);
+
+    PhaseTimer phases;
+    {
+        auto phase = phases.Phase("sort");
+    }
+    phases.Add("search", 5);
+    phases.Add("sort", 2);
+    assert(phases.Phases().size() == 2 && phases.Phases()[0].first == "sort" && phases.Phases()[0].second >= 2);
+    assert(phases.TotalMicroseconds() >= 7);
+
+    vector<Book> newbooks, requests;
+    for (size_t i = 0; i < 100; ++i) {
+        newbooks.push_back(Book("english", "new", i));
+        requests.push_back(Book("english", "new", i * 2));
+    }
+    Searcher searcher(newbooks, SearchMethod::Binary);
+    LatencyHistogram latency;
+    assert(searcher.countFoundParallel(requests, 3, &latency) == 50);
+    assert(latency.Count() == requests.size());
+    std::cout << "Instrumentation tests passed!" << std::endl;
+}
+
+void test_parallel_sort() {
+    const char* langs[] = { "english", "french", "spanish", "german" };
+    const char* types[] = { "new", "used", "digital", "hardcover" };
+    std::mt19937_64 rng(14);
+    for (size_t n : { size_t(0), size_t(100), size_t(5000), size_t(100000) }) {
+        for (size_t isbnRange : { size_t(1) << 62, size_t(9800000000000ULL), n / 4 + 1 }) {
+            vector<Book> books;
+            for (size_t i = 0; i < n; ++i) {
+                size_t isbn = isbnRange == 9800000000000ULL ? 9780000000000ULL + rng() % 20000000000ULL : rng() % isbnRange;
+                books.push_back(Book(langs[rng() % 4], types[rng() % 4], isbn));
+            }
+            vector<Book> expected = books;
+            std::sort(expected.begin(), expected.end());
+            for (unsigned threads : { 1u, 3u, 8u }) {
+                vector<Book> sorted = books;
+                parallelSortBooks(sorted, threads);
+                assert(sorted == expected);
+            }
+        }
+    }
+    // One ISBN shared by most of the catalog: the tie-break must not go
+    // quadratic in the run length, and the run spans many threads' chunks
+    vector<Book> skewed;
+    for (size_t i = 0; i < 200000; ++i) {
+        skewed.push_back(Book(langs[rng() % 4], types[rng() % 4], i % 4 ? 9780000000000ULL : rng() % 1000000));
+    }
+    vector<Book> expected = skewed;
+    std::sort(expected.begin(), expected.end());
+    for (unsigned threads : { 2u, 8u }) {
+        vector<Book> sorted = skewed;
+        Timer timer;
+        parallelSortBooks(sorted, threads);
+        assert(sorted == expected);
+        assert(timer.ElapsedMicroseconds() < 2e6);
+    }
+    std::cout << "Parallel sort tests passed!" << std::endl;
+}
+
+void test_server() {
+    vector<Book> newbooks;
+    for (size_t i = 0; i < 100; ++i) newbooks.push_back(Book("english", "new", i * 2));
+    std::sort(newbooks.begin(), newbooks.end());
+    Searcher searcher(newbooks, SearchMethod::Merge);
+    const std::string request = "4,english,new\n5,english,new\n\nbad\r\n6,english,used\n8,english,new";
+    const std::string expected = "4,english,new\tfound\n5,english,new\tnot found\nbad\tmalformed\n"
+                                 "6,english,used\tnot found\n8,english,new\tfound\n";
+
+    // One session over plain file descriptors, as with stdin/stdout
+    const char* inPath = "test_server_in_tmp.dat";
+    const char* outPath = "test_server_out_tmp.dat";
+    { std::ofstream(inPath) << request; }
+    int in = ::open(inPath, O_RDONLY);
+    int out = ::open(outPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ServerStats stats;
+    assert(serveConnection(searcher, in, out, &stats));
+    ::close(in);
+    ::close(out);
+    std::ifstream f(outPath);
+    std::string response((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    assert(response == expected);
+    assert(stats.requests == 4 && stats.found == 2 && stats.malformed == 1 && stats.connections == 1);
+    std::remove(inPath);
+    std::remove(outPath);
+
+    // Several clients of a socket server, each sending in two messages
+    const char* socketPath = "test_server_tmp.sock";
+    std::atomic<bool> stop{false};
+    ServerStats socketStats;
+    std::thread server([&] { assert(serveUnixSocket(searcher, socketPath, stop, &socketStats)); });
+    for (int client = 0; client < 3; ++client) {
+        int fd = -1;
+        for (int attempt = 0; attempt < 100 && fd < 0; ++attempt) {
+            fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            std::strcpy(addr.sun_path, socketPath);
+            if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+                ::close(fd);
+                fd = -1;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));  // Server still starting
+            }
+        }
+        assert(fd >= 0);
+        size_t half = request.size() / 2;
+        assert(::write(fd, request.data(), half) == static_cast<ssize_t>(half));
+        assert(::write(fd, request.data() + half, request.size() - half) == static_cast<ssize_t>(request.size() - half));
+        ::shutdown(fd, SHUT_WR);
+        std::string reply;
+        char buf[256];
+        for (ssize_t n; (n = ::read(fd, buf, sizeof(buf))) > 0;) reply.append(buf, n);
+        ::close(fd);
+        assert(reply == expected);
+    }
+    stop = true;
+    server.join();
+    assert(socketStats.connections == 3 && socketStats.found == 6);
+    assert(::access(socketPath, F_OK) != 0);  // Socket file removed
+    std::cout << "Server tests passed!" << std::endl;
+}
+
+/** A record type of our own, to check the kernels are not tied to Book. */
+struct Edition {
+    uint64_t isbn;
+    uint32_t price;
+};
+
+struct EditionIsbn {
+    using Key = uint64_t;
+    static uint64_t key(const Edition& e) { return e.isbn; }
+    static bool less(uint64_t a, uint64_t b) { return a < b; }
+};
+
+void test_search_kernels() {
+    // Branchless lower bound agrees with std::lower_bound at every size,
+    // for keys below, between, on and above the records
+    std::mt19937_64 rng(16);
+    for (size_t n = 0; n < 70; ++n) {
+        vector<Edition> editions;
+        for (size_t i = 0; i < n; ++i) editions.push_back({rng() % 50 * 2, static_cast<uint32_t>(i)});
+        std::sort(editions.begin(), editions.end(),
+                  [](const Edition& a, const Edition& b) { return a.isbn < b.isbn; });
+        for (uint64_t isbn = 0; isbn < 102; ++isbn) {
+            auto expected = std::lower_bound(editions.begin(), editions.end(), isbn,
+                                             [](const Edition& e, uint64_t k) { return e.isbn < k; });
+            assert(branchlessLowerBound<EditionIsbn>(editions.begin(), editions.end(), isbn) == expected);
+            assert(lowerBoundBy<EditionIsbn>(editions.begin(), editions.end(), isbn) == expected);
+            bool hit = expected != editions.end() && expected->isbn == isbn;
+            assert(branchlessFind<EditionIsbn>(editions.begin(), editions.end(), isbn) == hit);
+            assert(binaryFind<EditionIsbn>(editions.begin(), editions.end(), isbn) == hit);
+            assert(linearFind<EditionIsbn>(editions.begin(), editions.end(), isbn) == hit);
+            assert(n == 0 || recursiveFind<EditionIsbn>(editions.begin(), isbn, 0, n - 1) == hit);
+            auto run = equalRun<EditionIsbn>(editions.begin(), editions.end(), isbn);
+            assert(run.first == expected && std::all_of(run.first, run.second,
+                                                        [isbn](const Edition& e) { return e.isbn == isbn; }));
+            assert(run.second == editions.end() || run.second->isbn != isbn);
+        }
+    }
+
+    // Plain arrays work too, and mergeFind answers in request order
+    const Edition raw[] = { {3, 0}, {5, 1}, {5, 2}, {9, 3} };
+    const uint64_t wanted[] = { 9, 4, 5, 0, 3 };
+    vector<bool> found = mergeFind<EditionIsbn>(std::begin(raw), std::end(raw), std::begin(wanted), std::end(wanted));
+    assert((found == vector<bool>{true, false, true, false, true}));
+    assert(branchlessLowerBound<EditionIsbn>(std::begin(raw), std::end(raw), 5) == raw + 1);
+
+    // The Book policies give the same answers as the vector wrappers
+    vector<Book> books = { Book("english", "new", 7), Book("french", "used", 7), Book("english", "new", 8) };
+    std::sort(books.begin(), books.end());
+    assert(branchlessFind<BookOrder>(books.begin(), books.end(), books[1]));
+    assert(!branchlessFind<BookOrder>(books.begin(), books.end(), Book("french", "new", 7)));
+    assert(branchlessLowerBound<IsbnOrder>(books.begin(), books.end(), 8) == books.begin() + 2);
+    std::cout << "Search kernel tests passed!" << std::endl;
+}
+
+void test_bloom_filter() {
+    std::mt19937_64 rng(17);
+    const char* langs[] = { "english", "french", "spanish" };
+    const char* types[] = { "new", "used", "digital" };
+    vector<Book> books;
+    for (size_t i = 0; i < 20000; ++i) books.push_back(Book(langs[rng() % 3], types[rng() % 3], rng() % 1000000000));
+    std::sort(books.begin(), books.end());
+
+    // No false negatives, and the false-positive rate is near its target
+    BloomSettings settings;
+    settings.falsePositiveRate = 0.01;
+    BlockedBloomFilter filter(books, settings);
+    for (const auto& b : books) assert(filter.mayContain(b));
+    size_t falsePositives = 0, absent = 0;
+    for (size_t i = 0; i < 100000; ++i) {
+        Book probe(langs[rng() % 3], types[rng() % 3], 1000000000 + rng() % 1000000000);  // Outside the catalog
+        ++absent;
+        falsePositives += filter.mayContain(probe);
+    }
+    double fpr = static_cast<double>(falsePositives) / absent;
+    assert(fpr < 0.02);
+    assert(filter.expectedFalsePositiveRate() < 0.02 && filter.memoryBytes() % 64 == 0);
+
+    // A memory cap is honoured, at the cost of more false positives
+    settings.maxBytes = 4096;
+    BlockedBloomFilter small(books, settings);
+    assert(small.memoryBytes() == 4096 && small.expectedFalsePositiveRate() > filter.expectedFalsePositiveRate());
+    for (const auto& b : books) assert(small.mayContain(b));
+
+    // Every method gives the same answers behind the filter, and the
+    // counters add up
+    vector<Book> requests;
+    for (size_t i = 0; i < 2000; ++i) {
+        if (i % 4 == 0) requests.push_back(books[rng() % books.size()]);
+        else requests.push_back(Book(langs[rng() % 3], types[rng() % 3], rng() % 2000000000));
+    }
+    for (const char* letter : { "l", "b", "r", "m", "h", "e", "c", "p" }) {
+        SearchMethod method;
+        parseSearchMethod(letter, method);
+        Searcher plain(books, method);
+        Searcher filtered(books, method);
+        filtered.enableFilter(BloomSettings());
+        assert(plain.filter() == nullptr && filtered.filter() != nullptr);
+        assert(filtered.findBatch(requests) == plain.findBatch(requests));
+        size_t found = filtered.countFoundParallel(requests, 3);
+        assert(found == plain.countFoundParallel(requests, 3));
+        assert(filtered.find(requests[0]));
+
+        FilterStats stats = filtered.filterStats();
+        assert(stats.rejected + stats.passed == 2 * requests.size() + 1);
+        assert(stats.passed - stats.falsePositives == 2 * found + 1);
+        assert(stats.rejected > requests.size());  // Most of the 3/4 misses, twice over
+        assert(plain.filterStats().passed == 0);
+    }
+    std::cout << "Bloom filter tests passed!" << std::endl;
+}
+
+void test_learned_index() {
+    auto checkLowerBounds = [](const vector<Book>& books, const LearnedIndex& index, std::mt19937_64& rng) {
+        auto expected = [&](size_t q) {
+            return static_cast<size_t>(std::partition_point(books.begin(), books.end(),
+                                       [q](const Book& b) { return b.getISBN() < q; }) - books.begin());
+        };
+        for (const auto& b : books) {
+            assert(index.lowerBound(b.getISBN()) == expected(b.getISBN()));
+            assert(index.lowerBound(b.getISBN() + 1) == expected(b.getISBN() + 1));
+            assert(index.contains(b));
+        }
+        for (size_t q : { size_t(0), size_t(1), ~size_t(0) }) assert(index.lowerBound(q) == expected(q));
+        size_t hi = books.empty() ? 1 : books.back().getISBN() + 2;
+        for (size_t i = 0; i < 20000; ++i) {
+            size_t q = rng() % hi;
+            assert(index.lowerBound(q) == expected(q));
+        }
+    };
+    std::mt19937_64 rng(18);
+
+    // Uniform 13-digit ISBNs: a handful of segments, exact answers
+    vector<Book> books;
+    for (size_t i = 0; i < 100000; ++i) books.push_back(Book("english", i % 2 ? "new" : "used", 9780000000000ULL + rng() % 20000000000ULL));
+    std::sort(books.begin(), books.end());
+    LearnedIndex index(books);
+    assert(index.usesModel() && index.segments() < books.size() / 100);
+    checkLowerBounds(books, index, rng);
+    assert(!index.contains(Book("english", "digital", books[0].getISBN())));
+
+    // Runs of editions longer than the error bound, which absent ISBNs
+    // right after them must see past
+    books.clear();
+    for (size_t isbn = 1000; isbn < 1000000; isbn += 10) {
+        size_t editions = rng() % 500 == 0 ? 40 : 1;
+        for (size_t e = 0; e < editions; ++e) books.push_back(Book("lang" + std::to_string(e), "new", isbn));
+    }
+    std::sort(books.begin(), books.end());
+    LearnedIndex small(books, 8);
+    assert(small.usesModel());
+    checkLowerBounds(books, small, rng);
+
+    // Clustered keys a line cannot follow within +-1: falls back to binary search
+    books.clear();
+    size_t isbn = 0;
+    for (size_t i = 0; i < 20000; ++i) {
+        isbn += rng() % 4 == 0 ? 1 + rng() % 1000000 : 1;
+        books.push_back(Book("english", "new", isbn));
+    }
+    LearnedIndex skewed(books, 1);
+    assert(!skewed.usesModel() && skewed.segments() == 0 && skewed.memoryBytes() == 0);
+    checkLowerBounds(books, skewed, rng);
+
+    vector<Book> empty;
+    LearnedIndex none(empty);
+    assert(none.lowerBound(5) == 0 && !none.contains(Book("english", "new", 5)));
+    std::cout << "Learned index tests passed!" << std::endl;
+}
+
+void test_string_arena() {
+    StringArena arena(16);
+    assert(arena.used() == 0 && arena.allocated() == 0);
+    std::string_view a = arena.store("english");
+    std::string_view b = arena.store("hardcovers");  // Does not fit: starts a new block
+    std::string_view big = arena.store(std::string(100, 'x'));  // Larger than a block
+    std::string_view e = arena.store("");
+    assert(a == "english" && b == "hardcovers" && big == std::string(100, 'x') && e.empty());
+    assert(arena.used() == 117 && arena.allocated() == 16 + 16 + 100);
+
+    // Views handed out by the dictionary survive later interning
+    StringDictionary dict;
+    uint32_t id = dict.intern("spanish");
+    std::string_view view = dict.name(id);
+    for (int i = 0; i < 10000; ++i) dict.intern("lang" + std::to_string(i));
+    assert(view == "spanish" && view.data() == dict.name(id).data());
+    assert(dict.find("lang9999") != StringDictionary::npos);
+
+    // Dropping mapped pages keeps them readable
+    const char* path = "test_arena_tmp.dat";
+    {
+        std::ofstream f(path);
+        for (int i = 0; i < 5000; ++i) f << i << ",english,new\n";
+    }
+    MappedFile file;
+    assert(file.open(path));
+    std::string before(file.data(), file.size());
+    file.discard(file.size() / 2);
+    file.discard(file.size() + 1);
+    assert(std::string(file.data(), file.size()) == before);
+    vector<Book> books;
+    assert(loadBookFile(path, books) && books.size() == 5000 && books[4999] == Book("english", "new", 4999));
+    std::remove(path);
+    std::cout << "String arena tests passed!" << std::endl;
+}
+
+void test_result_set() {
+    vector<Book> books;
+    for (size_t i = 0; i < 500; ++i) books.push_back(Book(i % 2 ? "english" : "french", i % 3 ? "new" : "used", 1000 + i / 2));
+    std::sort(books.begin(), books.end());
+    vector<Book> requests;
+    for (size_t i = 0; i < 300; ++i) requests.push_back(Book(i % 4 ? "english" : "french", i % 5 ? "new" : "used", 900 + i));
+
+    // Per-request flags from the parallel count match findBatch, for every method
+    for (const char* letter : { "l", "b", "m", "h", "e", "c", "p" }) {
+        SearchMethod method;
+        assert(parseSearchMethod(letter, method));
+        Searcher searcher(books, method);
+        vector<bool> expected = searcher.findBatch(requests);
+        vector<uint8_t> hits;
+        LatencyHistogram latency;
+        size_t found = searcher.countFoundParallel(requests, 3, method == SearchMethod::Binary ? &latency : nullptr, &hits);
+        assert(hits.size() == requests.size());
+        for (size_t i = 0; i < requests.size(); ++i) assert(hits[i] == expected[i]);
+        assert(found == static_cast<size_t>(std::count(expected.begin(), expected.end(), true)));
+    }
+
+    Searcher searcher(books, SearchMethod::Binary);
+    vector<uint8_t> hits;
+    size_t found = searcher.countFoundParallel(requests, 2, nullptr, &hits);
+    assert(found > 0 && found < requests.size());
+
+    // Binary: one record per request, positions point at an equal record
+    const char* path = "test_results_tmp.dat";
+    assert(writeResultSet(path, ResultFormat::Binary, books, requests, hits));
+    vector<ResultRecord> records;
+    assert(readResultFile(path, records));
+    assert(records.size() == requests.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        assert(records[i].request == i && records[i].found() == (hits[i] != 0));
+        if (records[i].found()) assert(books[records[i].position] == requests[i]);
+    }
+
+    // Text: same results, one line each
+    assert(writeResultSet(path, ResultFormat::Text, books, requests, hits));
+    std::ifstream text(path);
+    std::string line;
+    for (size_t i = 0; i < records.size(); ++i) {
+        assert(std::getline(text, line));
+        std::string expected = std::to_string(i) + (records[i].found() ? "\tfound\t" + std::to_string(records[i].position) : "\tnot found");
+        assert(line == expected);
+    }
+    assert(!std::getline(text, line));
+    text.close();
+    std::string error;
+    assert(!readResultFile(path, records, &error) && error == "not a result file");
+
+    // A tiny buffer forces many flushes without changing the output
+    {
+        ResultWriter writer(1);
+        assert(writer.open(path, ResultFormat::Binary));
+        for (uint64_t i = 0; i < 10000; ++i) writer.add(i, i % 3 ? i * 2 : kNoPosition);
+        assert(writer.records() == 10000 && writer.close());
+    }
+    assert(readResultFile(path, records) && records.size() == 10000);
+    assert(records[9998].position == 9998 * 2 && !records[9999].found());
+    std::remove(path);
+
+    ResultFormat format;
+    assert(parseResultFormat("binary", format) && format == ResultFormat::Binary);
+    assert(!parseResultFormat("csv", format));
+    assert(!ResultWriter().open("no_such_dir/results.dat", ResultFormat::Text));
+    std::cout << "Result set tests passed!" << std::endl;
+}
+
+void test_allocation_free_lookups() {
+    vector<Book> books;
+    for (size_t i = 0; i < 2000; ++i) books.push_back(Book(i % 3 ? "english" : "german", i % 2 ? "new" : "digital", 5000 + i));
+    std::sort(books.begin(), books.end());
+    // Request text as it arrives: slices of one input buffer
+    std::string input = "english,new,german,digital,klingon";
+    std::string_view text(input);
+    std::string_view english = text.substr(0, 7), fresh = text.substr(8, 3), german = text.substr(12, 6),
+                     digital = text.substr(19, 7), unknown = text.substr(27);
+    BookHashIndex hash(books);
+    EytzingerIndex eytzinger(books);
+    BookColumns columns(books);
+    LearnedIndex learned(books);
+    vector<Searcher> searchers;
+    for (const char* letter : { "l", "b", "r", "m", "h", "e", "c", "p" }) {
+        SearchMethod method;
+        assert(parseSearchMethod(letter, method));
+        searchers.emplace_back(books, method);
+    }
+    searchers.back().enableFilter(BloomSettings());
+
+    size_t hits = 0;
+    auto lookups = [&] {
+        for (size_t isbn = 4990; isbn < 7010; isbn += 7) {
+            std::string_view lang = isbn % 3 ? english : german;
+            std::string_view type = isbn % 2 ? fresh : digital;
+            hits += linearSearch(books, lang, type, isbn) + binarySearch(books, lang, type, isbn)
+                  + recursiveBinarySearch(books, lang, type, isbn, 0, books.size() - 1)
+                  + hashSearch(hash, lang, type, isbn) + eytzingerSearch(eytzinger, lang, type, isbn)
+                  + columnarSearch(columns, lang, type, isbn) + learnedSearch(learned, lang, type, isbn)
+                  + !equalRange(books, lang, type, isbn).empty() + binarySearch(books, unknown, type, isbn);
+            Book key;
+            if (!encodeBook(lang, type, isbn, key)) continue;
+            for (const Searcher& searcher : searchers) hits += searcher.find(key);
+        }
+        for (const Book& b : books) hits += b.getLanguage() == english && b.getType() == fresh;
+    };
+    lookups();  // Warm up any lazily built statics
+    hits = 0;
+    size_t before = allocationCount;
+    lookups();
+    assert(allocationCount == before);
+    assert(hits > 0);
+
+    // Sanity check of the counter itself
+    std::string copy(books[0].getLanguage());
+    copy += " and some more text to defeat the small-string buffer";
+    assert(allocationCount > before);
+    std::cout << "Allocation-free lookup tests passed!" << std::endl;
+}
+
+void test_sharded_catalog() {
+    std::mt19937_64 rng(22);
+    vector<Book> books;
+    for (size_t i = 0; i < 3000; ++i) {
+        size_t isbn = 100000 + rng() % 5000;
+        for (size_t e = 0; e < 1 + rng() % 3; ++e) books.push_back(Book(e % 2 ? "english" : "polish", e ? "used" : "new", isbn));
+    }
+    std::sort(books.begin(), books.end());
+    books.erase(std::unique(books.begin(), books.end()), books.end());
+    vector<Book> requests;
+    for (size_t i = 0; i < 4000; ++i) {
+        requests.push_back(i % 2 ? books[rng() % books.size()] : Book("polish", "new", 99990 + rng() % 5100));
+    }
+    Searcher plain(books, SearchMethod::Binary);
+    vector<bool> expected = plain.findBatch(requests);
+    size_t expectedCount = std::count(expected.begin(), expected.end(), true);
+
+    assert(!numaTopology().empty() && !numaTopology()[0].cpus.empty());
+    for (unsigned shards : { 1u, 3u, 8u, 100000u }) {
+        for (const char* letter : { "b", "m", "h", "p" }) {
+            SearchMethod method;
+            assert(parseSearchMethod(letter, method));
+            ShardedCatalog catalog(books, shards, method, shards != 3);
+            assert(catalog.shards() >= 1 && catalog.shards() <= shards);
+            // Shards tile the catalog in order, and no ISBN straddles two
+            size_t total = 0;
+            for (size_t s = 0; s < catalog.shards(); ++s) {
+                const vector<Book>& part = catalog.shardBooks(s);
+                assert(!part.empty() && std::equal(part.begin(), part.end(), books.begin() + total));
+                assert(catalog.shardOf(part.front().getISBN()) == s && catalog.shardOf(part.back().getISBN()) == s);
+                if (s > 0) assert(catalog.shardBooks(s - 1).back().getISBN() < part.front().getISBN());
+                total += part.size();
+            }
+            assert(total == books.size());
+            assert(catalog.shardOf(0) == 0 && catalog.shardOf(~size_t(0)) == catalog.shards() - 1);
+
+            vector<uint8_t> found;
+            assert(catalog.countFound(requests, &found) == expectedCount);
+            assert(catalog.countFound(requests) == expectedCount);
+            for (size_t i = 0; i < requests.size(); ++i) {
+                assert(found[i] == expected[i]);
+                assert(catalog.find(requests[i]) == expected[i]);
+            }
+        }
+    }
+
+    // A filter and a cache on every shard change no answers; every shard
+    // filters and caches only its own requests
+    ShardedCatalog screened(books, 8, SearchMethod::Binary);
+    BloomSettings capped;
+    capped.maxBytes = 1 << 12;
+    screened.enableFilter(capped);
+    screened.enableCache(CacheSettings{1024});
+    for (int pass = 0; pass < 2; ++pass) assert(screened.countFound(requests) == expectedCount);
+    size_t rejected = 0, filterBytes = 0, hits = 0, lookups = 0, capacity = 0;
+    for (size_t s = 0; s < screened.shards(); ++s) {
+        const Searcher& shard = screened.shardSearcher(s);
+        assert(shard.filter() != nullptr && shard.cache() != nullptr);
+        rejected += shard.filterStats().rejected;
+        filterBytes += shard.filter()->memoryBytes();
+        hits += shard.cacheStats().hits;
+        lookups += shard.cacheStats().hits + shard.cacheStats().misses;
+        capacity += shard.cache()->capacity();
+    }
+    assert(rejected > 0 && filterBytes <= size_t(1 << 12) + screened.shards() * 64);
+    assert(lookups == 2 * requests.size() && hits > 0 && capacity >= 1024);
+
+    vector<Book> empty;
+    ShardedCatalog none(empty, 4, SearchMethod::Binary);
+    assert(none.shards() == 1 && none.countFound(requests) == 0 && !none.find(books[0]));
+    std::cout << "Sharded catalog tests passed!" << std::endl;
+}
+
+void test_interleaved_search() {
+    std::mt19937_64 rng(23);
+    for (size_t n : { size_t(0), size_t(1), size_t(2), size_t(17), size_t(1000), size_t(4099) }) {
+        vector<Book> books;
+        for (size_t i = 0; i < n; ++i) books.push_back(Book(i % 3 ? "english" : "welsh", i % 2 ? "new" : "used", rng() % (2 * n + 1)));
+        std::sort(books.begin(), books.end());
+        vector<Book> requests;
+        for (size_t i = 0; i < 333; ++i) {
+            requests.push_back(!books.empty() && i % 2 ? books[rng() % books.size()]
+                                                       : Book(i % 3 ? "english" : "welsh", "new", rng() % (2 * n + 3)));
+        }
+        for (size_t count : { size_t(0), size_t(1), kInterleaveGroup, kInterleaveGroup + 1, requests.size() }) {
+            vector<uint8_t> found(count, 7);
+            size_t expected = 0;
+            for (size_t i = 0; i < count; ++i) expected += binarySearch(books, requests[i]);
+            assert(interleavedBinarySearch(books, requests.data(), count, found.data()) == expected);
+            for (size_t i = 0; i < count; ++i) assert(found[i] == binarySearch(books, requests[i]));
+            assert(interleavedBinarySearch(books, requests.data(), count, nullptr) == expected);
+        }
+
+        // Through the Searcher, with and without a filter in front
+        SearchMethod method;
+        assert(parseSearchMethod("i", method) && method == SearchMethod::Interleaved && methodAnswersBatches(method));
+        Searcher plain(books, SearchMethod::Binary);
+        Searcher interleaved(books, method);
+        Searcher filtered(books, method);
+        filtered.enableFilter(BloomSettings());
+        vector<bool> expected = plain.findBatch(requests);
+        assert(interleaved.findBatch(requests) == expected && filtered.findBatch(requests) == expected);
+        vector<uint8_t> flags;
+        size_t count = filtered.countFoundParallel(requests, 2, nullptr, &flags);
+        assert(count == static_cast<size_t>(std::count(expected.begin(), expected.end(), true)));
+        for (size_t i = 0; i < requests.size(); ++i) assert(flags[i] == expected[i] && interleaved.find(requests[i]) == expected[i]);
+        FilterStats stats = filtered.filterStats();
+        assert(stats.rejected + stats.passed == 2 * requests.size());
+        assert(stats.passed - stats.falsePositives == 2 * count);
+    }
+    std::cout << "Interleaved search tests passed!" << std::endl;
+}
+
+void test_result_cache() {
+    // CLOCK keeps a referenced entry over unreferenced ones in a full set
+    ResultCache tiny(CacheSettings{ResultCache::kWays});
+    assert(tiny.capacity() == ResultCache::kWays);
+    Book hot("english", "new", 1);
+    bool found = false;
+    assert(!tiny.lookup(hot, found));
+    tiny.insert(hot, true);
+    assert(tiny.lookup(hot, found) && found);
+    // Fill the set, then evict a full sweep's worth of one-offs: the hand
+    // clears hot's bit once and passes it by
+    size_t oneOffs = 2 * (ResultCache::kWays - 1);
+    for (size_t isbn = 2; isbn < 2 + oneOffs; ++isbn) tiny.insert(Book("english", "new", isbn), isbn % 2 == 0);
+    assert(tiny.lookup(hot, found) && found);
+    assert(tiny.lookup(Book("english", "new", 2 + oneOffs - 1), found) && !found);
+    CacheStats stats = tiny.stats();
+    assert(stats.hits == 3 && stats.misses == 1 && stats.insertions == 1 + oneOffs);
+    assert(stats.evictions == ResultCache::kWays - 1);
+    tiny.insert(hot, false);  // Overwrites in place
+    assert(tiny.lookup(hot, found) && !found && tiny.stats().insertions == 1 + oneOffs);
+    tiny.invalidate();
+    assert(!tiny.lookup(hot, found) && tiny.stats().invalidations == 1);
+
+    // Every method gives the same answers behind the cache, with or without
+    // the filter, over a skewed stream that repeats a few hot requests
+    std::mt19937_64 rng(24);
+    vector<Book> books;
+    for (size_t i = 0; i < 5000; ++i) books.push_back(Book(i % 2 ? "english" : "french", i % 3 ? "new" : "used", rng() % 20000));
+    std::sort(books.begin(), books.end());
+    vector<Book> hotSet;
+    for (size_t i = 0; i < 64; ++i) hotSet.push_back(i % 2 ? books[rng() % books.size()] : Book("french", "new", rng() % 20000));
+    vector<Book> requests;
+    for (size_t i = 0; i < 3000; ++i) {
+        requests.push_back(i % 4 ? hotSet[rng() % hotSet.size()] : Book("english", "used", rng() % 20000));
+    }
+    Searcher plain(books, SearchMethod::Binary);
+    vector<bool> expected = plain.findBatch(requests);
+    size_t expectedCount = std::count(expected.begin(), expected.end(), true);
+    for (const char* letter : { "l", "b", "r", "m", "h", "e", "c", "p", "i", "z" }) {
+        SearchMethod method;
+        assert(parseSearchMethod(letter, method));
+        for (bool filter : { false, true }) {
+            Searcher cached(books, method);
+            if (filter) cached.enableFilter(BloomSettings());
+            cached.enableCache(CacheSettings{256});
+            assert(cached.cache() != nullptr && cached.cache()->capacity() >= 256);
+            assert(cached.findBatch(requests) == expected);
+            vector<uint8_t> flags;
+            assert(cached.countFoundParallel(requests, 3, nullptr, &flags) == expectedCount);
+            for (size_t i = 0; i < requests.size(); ++i) assert(flags[i] == expected[i] && cached.find(requests[i]) == expected[i]);
+            CacheStats s = cached.cacheStats();
+            assert(s.hits + s.misses == 3 * requests.size() && s.hits > 0 && s.insertions <= s.misses);
+        }
+    }
+    assert(plain.cache() == nullptr && plain.cacheStats().hits == 0);
+
+    // A cached Catalog sees its own updates
+    Catalog catalog(books);
+    catalog.enableCache(CacheSettings{64});
+    Book added("welsh", "new", 123456789);
+    assert(catalog.insert(added) && catalog.erase(added) && !catalog.erase(added));
+    assert(catalog.cacheStats().hits + catalog.cacheStats().misses == 0);  // Updates are not lookups
+    assert(!catalog.contains(added) && !catalog.contains(added));
+    assert(catalog.insert(added) && catalog.contains(added));
+    assert(catalog.erase(books[0]) && !catalog.contains(books[0]));
+    assert(catalog.insert(books[0]) && catalog.contains(books[0]));
+    catalog.compact();
+    assert(catalog.contains(added) && catalog.contains(books[0]));
+    assert(catalog.cacheStats().hits > 0);
+    std::cout << "Result cache tests passed!" << std::endl;
+}
+
+void test_compressed_catalog() {
+    std::mt19937_64 rng(25);
+    const char* langs[] = { "english", "french", "spanish", "german" };
+    const char* types[] = { "new", "used", "digital" };
+    vector<ScanKernel> kernels;
+    for (ScanKernel k : { ScanKernel::Scalar, ScanKernel::SSE42, ScanKernel::AVX2 }) {
+        if (scanKernelSupported(k)) kernels.push_back(k);
+    }
+    size_t block = CompressedCatalog::kBlockSize;
+    for (size_t n : { size_t(0), size_t(1), block - 1, block, block + 1, size_t(5000) }) {
+        for (int shape = 0; shape < 3; ++shape) {
+            // 0: dense ISBNs with a few editions each; 1: random gaps, some
+            // wider than 32 bits (raw blocks); 2: one ISBN in 300 editions
+            // (width-0 blocks, a run straddling block boundaries)
+            vector<Book> books;
+            size_t isbn = 9780000000000ULL;
+            for (size_t i = 0; i < n; ++i) {
+                if (shape == 2 && i % 400 < 300) {
+                    books.push_back(Book("lang" + std::to_string(i % 400), "new", isbn));
+                    continue;
+                }
+                isbn += shape == 1 ? (rng() % 600 == 0 ? (size_t(1) << 33) : rng() % 100000) : rng() % 3;
+                books.push_back(Book(langs[rng() % 4], types[rng() % 3], isbn));
+            }
+            std::sort(books.begin(), books.end());
+            books.erase(std::unique(books.begin(), books.end()), books.end());
+
+            CompressedCatalog catalog(books);
+            assert(catalog.size() == books.size() && catalog.decode() == books);
+            assert(catalog.blocks() >= (books.size() + block - 1) / block);
+            if (shape != 1) assert(catalog.blocks() == (books.size() + block - 1) / block);
+            vector<Book> requests;
+            for (size_t i = 0; i < 600; ++i) {
+                if (!books.empty() && i % 2) requests.push_back(books[rng() % books.size()]);
+                else requests.push_back(Book(langs[rng() % 4], types[rng() % 3], 9780000000000ULL - 5 + rng() % (isbn - 9780000000000ULL + 10)));
+            }
+            requests.push_back(Book("welsh", "new", books.empty() ? 1 : books[0].getISBN()));  // Unknown edition
+            for (const auto& r : requests) {
+                bool expected = binarySearch(books, r);
+                for (ScanKernel k : kernels) assert(catalog.contains(r, k) == expected);
+                assert(compressedSearch(catalog, r.getLanguage(), r.getType(), r.getISBN()) == expected);
+                BookRange match = equalRange(books, r);
+                size_t position = match.empty() ? CompressedCatalog::npos : static_cast<size_t>(match.first - books.begin());
+                assert(catalog.find(r) == position);
+            }
+            if (shape == 0 && n == 5000) assert(catalog.memoryBytes() * 4 < books.size() * sizeof(Book));
+        }
+    }
+
+    // The builder takes the books one at a time, and a Searcher answers
+    // through the catalog like every other method
+    vector<Book> books;
+    for (size_t i = 0; i < 3000; ++i) books.push_back(Book(langs[i % 4], types[i % 3], 1000 + rng() % 4000));
+    std::sort(books.begin(), books.end());
+    CompressedCatalogBuilder builder;
+    for (const auto& b : books) builder.add(b);
+    CompressedCatalog streamed = builder.finish();
+    assert(streamed.decode() == books && streamed.editions() == 12);
+    assert(builder.finish().size() == 0);
+    SearchMethod method;
+    assert(parseSearchMethod("z", method) && method == SearchMethod::Compressed && methodBuildsIndex(method));
+    Searcher compressed(books, method);
+    Searcher plain(books, SearchMethod::Binary);
+    vector<Book> requests;
+    for (size_t i = 0; i < 2000; ++i) requests.push_back(Book(langs[rng() % 4], types[rng() % 3], 900 + rng() % 4200));
+    assert(compressed.findBatch(requests) == plain.findBatch(requests));
+    assert(compressed.compressedCatalog() != nullptr && plain.compressedCatalog() == nullptr);
+
+    // A Searcher can own the catalog outright, filter included, and result
+    // sets come out the same without the books vector
+    Searcher owning{CompressedCatalog(books)};
+    owning.enableFilter(BloomSettings());
+    assert(owning.method() == SearchMethod::Compressed && owning.filter() != nullptr);
+    assert(owning.findBatch(requests) == plain.findBatch(requests));
+    for (const auto& b : books) assert(owning.filter()->mayContain(b));
+    vector<uint8_t> hits;
+    owning.countFoundParallel(requests, 2, nullptr, &hits);
+    const char* path = "test_compressed_results_tmp.dat";
+    vector<ResultRecord> fromVector, fromCatalog;
+    assert(writeResultSet(path, ResultFormat::Binary, books, requests, hits) && readResultFile(path, fromVector));
+    assert(writeResultSet(path, ResultFormat::Binary, *owning.compressedCatalog(), requests, hits));
+    assert(readResultFile(path, fromCatalog) && fromCatalog.size() == requests.size());
+    for (size_t i = 0; i < requests.size(); ++i) {
+        assert(fromCatalog[i].request == fromVector[i].request && fromCatalog[i].position == fromVector[i].position);
+    }
+    std::remove(path);
+    std::cout << "Compressed catalog tests passed!" << std::endl;
+}
+
+void test_type_id_limit() {
+    // Use up every type id; the next new type must be rejected everywhere
+    // it could be interned rather than wrap onto type 0 or kEmptyType
+    for (size_t i = 0; typeDictionary().size() < kTypeIdLimit; ++i) typeDictionary().intern("filler-type-" + std::to_string(i));
+    Book b;
+    assert(!parseBookRecord("1,english,one-type-too-many", b));
+    assert(parseBookRecord("1,english,new", b) && b == Book("english", "new", 1));
+    bool threw = false;
+    try {
+        Book("english", "one-type-too-many", 1);
+    } catch (const std::length_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // The rejected type was still given an id; neither request path may
+    // encode it (it would equal the hash index's empty-slot marker)
+    assert(typeDictionary().find("one-type-too-many") >= kTypeIdLimit);
+    assert(!encodeBook("english", "one-type-too-many", 1, b));
+    assert(encodeRequestRecord("1,english,one-type-too-many", b) == RequestRecord::Unknown);
+    assert(encodeRequestRecord("1,english,filler-type-7", b) == RequestRecord::Encoded);
+
+    const char* path = "test_type_limit_tmp.dat";
+    {
+        std::ofstream f(path);
+        f << "1,english,new\n2,english,another-type-too-many\n3,french,filler-type-7\n";
+    }
+    vector<Book> books;
+    LoadStats stats;
+    assert(loadBookFile(path, books, &stats));
+    assert(books.size() == 2 && stats.records == 2 && stats.malformed == 1);
+    std::remove(path);
+    for (const auto& book : books) assert(book.getTypeId() < kTypeIdLimit);
+    BookHashIndex index(books);
+    for (const auto& book : books) assert(index.contains(book));
+    std::cout << "Type id limit tests passed!" << std::endl;
+}
+
 int main() {
     test_all_hit();
     test_all_miss();
@@ -110,6 +1348,31 @@ int main() {
     test_type_mismatch();
     test_language_mismatch();
     test_book_comparators();
+    test_interned_fields();
+    test_merge_preserves_request_order();
+    test_hash_index_many();
+    test_eytzinger_lower_bound();
+    test_columnar_kernels();
+    test_parallel_searcher();
+    test_loader();
+    test_snapshot_roundtrip();
+    test_catalog_updates();
+    test_equal_range_editions();
+    test_stream_search();
+    test_instrumentation();
+    test_parallel_sort();
+    test_server();
+    test_search_kernels();
+    test_bloom_filter();
+    test_learned_index();
+    test_string_arena();
+    test_result_set();
+    test_allocation_free_lookups();
+    test_sharded_catalog();
+    test_interleaved_search();
+    test_result_cache();
+    test_compressed_catalog();
+    test_type_id_limit();  // Last: fills the type dictionary
     std::cout << "All unit tests passed!" << std::endl;
     return 0;
 }